@@ -0,0 +1,341 @@
+#pragma once
+
+// Minimal benchmark runner shared by the bench executables: repeats a sample
+// until a minimum time is spent, prints a table and writes the results as JSON.
+// With --counters it also reads hardware counters around the timed code.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+// Hardware events reported per operation with --counters
+inline constexpr size_t counter_count = 4;
+inline constexpr std::array<const char*, counter_count> counter_names = {
+    "cycles", "instructions", "cache_misses", "branch_misses"};
+
+// User space hardware counters of the calling thread through perf_event_open.
+// Events the kernel refuses (no PMU in a VM, perf_event_paranoid, seccomp, not
+// Linux) are unavailable and read as NaN instead of failing the benchmark.
+class perf_counters {
+public:
+    perf_counters() {
+#ifdef __linux__
+        constexpr std::array<uint64_t, counter_count> configs = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES};
+        for (size_t i = 0; i < counter_count; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        }
+#endif
+    }
+
+    ~perf_counters() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    bool available(size_t counter) const noexcept {
+        return fds[counter] >= 0;
+    }
+
+    bool any_available() const noexcept {
+        return std::any_of(fds.begin(), fds.end(), [](int fd) { return fd >= 0; });
+    }
+
+    void start() noexcept {
+#ifdef __linux__
+        for (size_t i = 0; i < counter_count; ++i) {
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+            started[i] = read_event(fds[i]);
+        }
+#endif
+    }
+
+    // Adds the events since start() to the totals, scaled up when the kernel
+    // multiplexed the counter and it ran for only part of the interval
+    void stop() noexcept {
+#ifdef __linux__
+        for (size_t i = 0; i < counter_count; ++i) {
+            if (fds[i] < 0) continue;
+            reading now = read_event(fds[i]);
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t running = now.running - started[i].running;
+            uint64_t enabled = now.enabled - started[i].enabled;
+            double value = double(now.value - started[i].value);
+            if (running > 0 && running < enabled) value *= double(enabled) / double(running);
+            totals[i] += value;
+        }
+#endif
+    }
+
+    // Events counted since the last clear(), NaN for unavailable counters
+    std::array<double, counter_count> read() const noexcept {
+        std::array<double, counter_count> values;
+        for (size_t i = 0; i < counter_count; ++i) values[i] = available(i) ? totals[i] : NAN;
+        return values;
+    }
+
+    void clear() noexcept {
+        totals.fill(0);
+    }
+
+private:
+    struct reading {
+        uint64_t value = 0;
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+
+    std::array<int, counter_count> fds = {-1, -1, -1, -1};
+    std::array<reading, counter_count> started{};
+    std::array<double, counter_count> totals{};
+
+#ifdef __linux__
+    static reading read_event(int fd) noexcept {
+        reading result;
+        if (::read(fd, &result, sizeof(result)) != ssize_t(sizeof(result))) return reading();
+        return result;
+    }
+#endif
+};
+
+// Counters read around every time_seconds() call, set by the runner
+inline perf_counters* active_counters = nullptr;
+
+// Seconds spent in one call of body, for samples that need untimed setup
+template<typename F>
+double time_seconds(F&& body) {
+    if (active_counters) active_counters->start();
+    auto start = clock::now();
+    body();
+    auto stop = clock::now();
+    if (active_counters) active_counters->stop();
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+// Keeps the compiler from discarding a computed value
+template<typename T>
+void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Trivially copyable element of Size bytes, keyed so that reads can be summed
+template<size_t Size>
+struct blob {
+    static_assert(Size >= sizeof(uint32_t), "blob holds at least its key");
+
+    uint32_t key;
+    unsigned char payload[Size - sizeof(uint32_t)];
+
+    blob(uint32_t key = 0) : key(key), payload{} {}
+};
+
+// A blob of only the key has no payload, a zero-length array is ill-formed
+template<>
+struct blob<sizeof(uint32_t)> {
+    uint32_t key;
+
+    blob(uint32_t key = 0) : key(key) {}
+};
+
+// Identifies one measured case in the table and the JSON output
+struct case_info {
+    std::string benchmark; // Operation, e.g. "push_back"
+    std::string container; // Container type, e.g. "unrolled_list"
+    size_t element_size; // sizeof the element type
+    size_t node_max_size; // NodeMaxSize, 0 for standard containers
+    size_t size; // Number of elements the case works on
+};
+
+struct result {
+    case_info info;
+    size_t repetitions; // Samples taken
+    double ns_per_op; // Median over the samples
+    double min_ns_per_op; // Fastest sample
+    // Events per operation averaged over the samples, NaN when not counted
+    std::array<double, counter_count> counters_per_op;
+};
+
+class runner {
+public:
+    // Options: --json=<path> writes the results, --filter=<text> runs only
+    // cases whose name contains text, --min-time=<seconds> per case,
+    // --counters adds hardware counters per operation
+    runner(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg.starts_with("--json=")) {
+                json_path = arg.substr(7);
+            } else if (arg.starts_with("--filter=")) {
+                filter = arg.substr(9);
+            } else if (arg.starts_with("--min-time=")) {
+                min_time = std::atof(std::string(arg.substr(11)).c_str());
+            } else if (arg == "--counters") {
+                counters = std::make_unique<perf_counters>();
+            } else {
+                std::cerr << "unknown option " << arg << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        if (counters && !counters->any_available()) {
+            std::cerr << "hardware counters unavailable, reporting time only\n";
+            counters.reset();
+        }
+        std::cout << std::left << std::setw(44) << "case" << std::right << std::setw(14) << "ns/op"
+                  << std::setw(14) << "min ns/op" << std::setw(8) << "reps";
+        if (counters) {
+            std::cout << std::setw(12) << "cycles/op" << std::setw(12) << "instr/op" << std::setw(12) << "cmiss/op"
+                      << std::setw(12) << "bmiss/op";
+        }
+        std::cout << "\n";
+    }
+
+    static std::string name(const case_info& info) {
+        std::string text = info.benchmark + "/" + info.container + "/T" + std::to_string(info.element_size);
+        if (info.node_max_size) text += "/N" + std::to_string(info.node_max_size);
+        return text + "/" + std::to_string(info.size);
+    }
+
+    bool selected(const case_info& info) const {
+        return filter.empty() || name(info).find(filter) != std::string::npos;
+    }
+
+    // sample() performs ops operations and returns the seconds they took. It
+    // is repeated until min_time has been spent, at least three times.
+    template<typename Sample>
+    void run(const case_info& info, size_t ops, Sample sample) {
+        if (!selected(info)) return;
+
+        std::vector<double> samples;
+        double spent = 0;
+        if (counters) {
+            counters->clear();
+            active_counters = counters.get();
+        }
+        while (samples.size() < 3 || (spent < min_time && samples.size() < 1000)) {
+            double seconds = sample();
+            spent += seconds;
+            samples.push_back(seconds * 1e9 / double(ops));
+        }
+        active_counters = nullptr;
+
+        std::array<double, counter_count> per_op;
+        per_op.fill(NAN);
+        if (counters) {
+            per_op = counters->read();
+            for (double& value : per_op) value /= double(ops) * double(samples.size());
+        }
+        std::sort(samples.begin(), samples.end());
+
+        result entry{info, samples.size(), samples[samples.size() / 2], samples.front(), per_op};
+        std::cout << std::left << std::setw(44) << name(info) << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(14) << entry.ns_per_op << std::setw(14) << entry.min_ns_per_op
+                  << std::setw(8) << entry.repetitions;
+        if (counters) {
+            for (double value : per_op) {
+                if (std::isnan(value)) {
+                    std::cout << std::setw(12) << "-";
+                } else {
+                    std::cout << std::setw(12) << value;
+                }
+            }
+        }
+        std::cout << std::endl;
+        results.push_back(entry);
+    }
+
+    const std::vector<result>& measured() const noexcept {
+        return results;
+    }
+
+    // Writes the JSON file if one was requested, returns the exit code
+    int finish() const {
+        if (json_path.empty()) return EXIT_SUCCESS;
+        std::ofstream out(json_path);
+        out << "{\n  \"context\": {\"date\": " << std::time(nullptr) << ", \"compiler\": \"" << escape(__VERSION__)
+            << "\", \"min_time\": " << min_time << ", \"counters\": " << (counters ? "true" : "false") << "},\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const result& entry = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": \"" << escape(name(entry.info)) << "\", \"benchmark\": \""
+                << escape(entry.info.benchmark) << "\", \"container\": \"" << escape(entry.info.container)
+                << "\", \"element_size\": " << entry.info.element_size << ", \"node_max_size\": "
+                << entry.info.node_max_size << ", \"size\": " << entry.info.size << ", \"repetitions\": "
+                << entry.repetitions << ", \"ns_per_op\": " << entry.ns_per_op << ", \"min_ns_per_op\": "
+                << entry.min_ns_per_op;
+            if (counters) {
+                for (size_t counter = 0; counter < counter_count; ++counter) {
+                    out << ", \"" << counter_names[counter] << "_per_op\": ";
+                    if (std::isnan(entry.counters_per_op[counter])) {
+                        out << "null";
+                    } else {
+                        out << entry.counters_per_op[counter];
+                    }
+                }
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+        if (!out) {
+            std::cerr << "cannot write " << json_path << "\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+private:
+    std::string json_path;
+    std::string filter;
+    double min_time = 0.1;
+    std::unique_ptr<perf_counters> counters; // Set by --counters when any event can be counted
+    std::vector<result> results;
+
+    static std::string escape(std::string_view text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,111 @@
+// Mixed read/write throughput of concurrent_unrolled_list against an
+// unrolled_list guarded by one global mutex
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <concurrent_unrolled_list.h>
+#include <unrolled_list.h>
+
+namespace {
+
+constexpr size_t InitialSize = 20000;
+constexpr size_t OpsPerThread = 20000;
+constexpr unsigned ReadPercent = 60; // The rest is split evenly between inserts and erases
+
+class locked_list {
+public:
+    locked_list() {
+        for (size_t i = 0; i < InitialSize; ++i) list.push_back(static_cast<int>(i));
+    }
+
+    bool get(size_t index) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (index >= list.size()) return false;
+        return list[index] >= 0;
+    }
+
+    void insert(size_t index, int value) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (index > list.size()) index = list.size();
+        list.insert(std::next(list.begin(), index), value);
+    }
+
+    void erase(size_t index) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (index >= list.size()) return;
+        list.erase(std::next(list.begin(), index));
+    }
+
+private:
+    std::mutex mutex;
+    unrolled_list<int, 64> list;
+};
+
+class fine_grained_list {
+public:
+    fine_grained_list() {
+        for (size_t i = 0; i < InitialSize; ++i) list.push_back(static_cast<int>(i));
+    }
+
+    bool get(size_t index) {
+        auto value = list.get(index);
+        return value && *value >= 0;
+    }
+
+    void insert(size_t index, int value) {
+        list.insert(index, value);
+    }
+
+    void erase(size_t index) {
+        list.erase(index);
+    }
+
+private:
+    concurrent_unrolled_list<int, 64> list;
+};
+
+template<typename List>
+double run(unsigned threads) {
+    List list;
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&list, t] {
+            std::mt19937 rng(t + 1);
+            std::uniform_int_distribution<size_t> index(0, InitialSize - 1);
+            std::uniform_int_distribution<unsigned> percent(0, 99);
+            for (size_t i = 0; i < OpsPerThread; ++i) {
+                unsigned op = percent(rng);
+                if (op < ReadPercent) {
+                    list.get(index(rng));
+                } else if (op % 2 == 0) {
+                    list.insert(index(rng), static_cast<int>(i));
+                } else {
+                    list.erase(index(rng));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads * OpsPerThread / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+    std::cout << "threads  global_mutex_ops/s  per_node_locks_ops/s\n";
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        double locked = run<locked_list>(threads);
+        double fine = run<fine_grained_list>(threads);
+        std::cout << threads << "  " << static_cast<long long>(locked) << "  "
+                  << static_cast<long long>(fine) << "\n";
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+// unrolled_list against std::vector, std::deque and std::list: pushes and
+// pops at both ends, middle insert/erase, iteration, indexed access, copy
+// and clear for several element sizes and NodeMaxSize values
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unrolled_list.h>
+
+#include "bench_harness.h"
+
+namespace {
+
+constexpr size_t LargeSize = 100'000; // Elements for O(1) per element operations
+constexpr size_t SmallSize = 4'096; // Elements for O(n) per element operations
+constexpr size_t IndexedOps = 1'000;
+
+template<typename Container>
+struct traits {
+    static constexpr size_t node_max_size = 0;
+};
+
+template<typename T, size_t N, typename A, typename I, typename C>
+struct traits<unrolled_list<T, N, A, I, C>> {
+    static constexpr size_t node_max_size = N;
+};
+
+template<typename Container>
+void push_front(Container& c, const typename Container::value_type& value) {
+    if constexpr (requires { c.push_front(value); }) {
+        c.push_front(value);
+    } else {
+        c.insert(c.begin(), value);
+    }
+}
+
+template<typename Container>
+void pop_front(Container& c) {
+    if constexpr (requires { c.pop_front(); }) {
+        c.pop_front();
+    } else {
+        c.erase(c.begin());
+    }
+}
+
+template<typename Container>
+Container filled(size_t count) {
+    Container c;
+    for (size_t i = 0; i < count; ++i) c.push_back(typename Container::value_type(uint32_t(i)));
+    return c;
+}
+
+template<typename Container>
+void run_all(bench::runner& runner, const std::string& container) {
+    using T = typename Container::value_type;
+    auto info = [&](const std::string& benchmark, size_t size) {
+        return bench::case_info{benchmark, container, sizeof(T), traits<Container>::node_max_size, size};
+    };
+
+    runner.run(info("push_back", LargeSize), LargeSize, [] {
+        Container c;
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < LargeSize; ++i) c.push_back(T(uint32_t(i)));
+        });
+    });
+
+    runner.run(info("push_front", SmallSize), SmallSize, [] {
+        Container c;
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) push_front(c, T(uint32_t(i)));
+        });
+    });
+
+    runner.run(info("pop_back", LargeSize), LargeSize, [] {
+        Container c = filled<Container>(LargeSize);
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < LargeSize; ++i) c.pop_back();
+        });
+    });
+
+    runner.run(info("pop_front", SmallSize), SmallSize, [] {
+        Container c = filled<Container>(SmallSize);
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) pop_front(c);
+        });
+    });
+
+    runner.run(info("insert_middle", SmallSize), SmallSize, [] {
+        Container c = filled<Container>(SmallSize);
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) c.insert(std::next(c.begin(), c.size() / 2), T(uint32_t(i)));
+        });
+    });
+
+    runner.run(info("erase_middle", SmallSize), SmallSize, [] {
+        Container c = filled<Container>(2 * SmallSize);
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) c.erase(std::next(c.begin(), c.size() / 2));
+        });
+    });
+
+    Container large = filled<Container>(LargeSize);
+
+    runner.run(info("iterate", LargeSize), LargeSize, [&large] {
+        return bench::time_seconds([&] {
+            uint64_t sum = 0;
+            for (const T& item : large) sum += item.key;
+            bench::do_not_optimize(sum);
+        });
+    });
+
+    if constexpr (requires(Container& c) { c[0]; }) {
+        runner.run(info("indexed", SmallSize), IndexedOps, [] {
+            Container c = filled<Container>(SmallSize);
+            std::mt19937 random(42);
+            std::vector<size_t> indices(IndexedOps);
+            for (size_t& index : indices) index = random() % SmallSize;
+            return bench::time_seconds([&] {
+                uint64_t sum = 0;
+                for (size_t index : indices) sum += c[index].key;
+                bench::do_not_optimize(sum);
+            });
+        });
+    }
+
+    runner.run(info("copy", LargeSize), LargeSize, [&large] {
+        return bench::time_seconds([&] {
+            Container copy(large);
+            bench::do_not_optimize(copy.size());
+        });
+    });
+
+    runner.run(info("clear", LargeSize), LargeSize, [] {
+        Container c = filled<Container>(LargeSize);
+        return bench::time_seconds([&] { c.clear(); });
+    });
+}
+
+template<typename T>
+void run_element(bench::runner& runner) {
+    run_all<unrolled_list<T, 16>>(runner, "unrolled_list");
+    run_all<unrolled_list<T, 64>>(runner, "unrolled_list");
+    run_all<unrolled_list<T, 256>>(runner, "unrolled_list");
+    run_all<std::vector<T>>(runner, "vector");
+    run_all<std::deque<T>>(runner, "deque");
+    run_all<std::list<T>>(runner, "list");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::runner runner(argc, argv);
+    run_element<bench::blob<4>>(runner);
+    run_element<bench::blob<32>>(runner);
+    run_element<bench::blob<128>>(runner);
+    return runner.finish();
+}
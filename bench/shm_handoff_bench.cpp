@@ -0,0 +1,119 @@
+// Two processes handing batches of records to each other: shm_unrolled_list
+// nodes filled and read in place against a pipe carrying serialized
+// unrolled_list batches
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <shm_unrolled_list.h>
+#include <unrolled_list.h>
+
+namespace {
+
+struct Record {
+    uint64_t id;
+    uint64_t timestamp;
+    double values[6];
+};
+
+constexpr size_t BatchSize = 256;
+constexpr uint64_t Records = 4'000'000;
+constexpr size_t PoolNodes = 64;
+
+Record make_record(uint64_t id) {
+    return Record{id, id * 3, {double(id), 1, 2, 3, 4, 5}};
+}
+
+// Sum of ids the consumer must see
+constexpr uint64_t expected_sum() {
+    return Records * (Records - 1) / 2;
+}
+
+pid_t fork_consumer(auto consumer) {
+    pid_t pid = ::fork();
+    if (pid < 0) std::abort();
+    if (pid == 0) ::_exit(consumer() == expected_sum() ? EXIT_SUCCESS : EXIT_FAILURE);
+    return pid;
+}
+
+void join(pid_t pid) {
+    int status = 0;
+    if (::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        std::cerr << "consumer failed\n";
+        std::abort();
+    }
+}
+
+// Records per second through a shared memory segment
+double shm_throughput() {
+    using shm_list = shm_unrolled_list<Record, BatchSize>;
+    std::string name = "/unrolled_list_bench_" + std::to_string(::getpid());
+    shm_list::unlink(name);
+    shm_list list = shm_list::create(name, PoolNodes);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t consumer = fork_consumer([&name] {
+        shm_list shared = shm_list::open(name);
+        uint64_t sum = 0;
+        while (auto node = shared.consume()) {
+            for (const Record& record : node.elements()) sum += record.id;
+        }
+        return sum;
+    });
+
+    for (uint64_t id = 0; id < Records;) {
+        auto node = list.acquire();
+        while (!node.full() && id < Records) node.push_back(make_record(id++));
+        list.publish(std::move(node));
+    }
+    list.close();
+    join(consumer);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    shm_list::unlink(name);
+    return Records / elapsed.count();
+}
+
+// Records per second through a pipe, one serialized unrolled_list per batch
+double pipe_throughput() {
+    using batch_list = unrolled_list<Record, BatchSize>;
+    int fds[2];
+    if (::pipe(fds) != 0) std::abort();
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t consumer = fork_consumer([&fds] {
+        ::close(fds[1]);
+        uint64_t sum = 0;
+        for (uint64_t received = 0; received < Records;) {
+            batch_list batch = batch_list::deserialize(fds[0]);
+            for (const Record& record : batch) sum += record.id;
+            received += batch.size();
+        }
+        return sum;
+    });
+    ::close(fds[0]);
+
+    batch_list batch;
+    for (uint64_t id = 0; id < Records;) {
+        batch.clear();
+        while (batch.size() < BatchSize && id < Records) batch.push_back(make_record(id++));
+        batch.serialize(fds[1]);
+    }
+    ::close(fds[1]);
+    join(consumer);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return Records / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    std::cout << "transport                  records/s\n";
+    std::cout << "pipe+serialize             " << static_cast<long long>(pipe_throughput()) << "\n";
+    std::cout << "shm_unrolled_list          " << static_cast<long long>(shm_throughput()) << "\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+// Producer/consumer handoff through spsc_unrolled_queue against an
+// unrolled_list guarded by a mutex: streaming throughput and ping-pong latency
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <spsc_unrolled_queue.h>
+#include <unrolled_list.h>
+
+namespace {
+
+constexpr uint64_t ThroughputItems = 5'000'000;
+constexpr uint64_t RoundTrips = 100'000;
+
+class locked_queue {
+public:
+    void push(uint64_t value) {
+        std::lock_guard<std::mutex> guard(mutex);
+        list.push_back(value);
+    }
+
+    std::optional<uint64_t> try_pop() {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (list.empty()) return std::nullopt;
+        uint64_t value = list.front();
+        list.pop_front();
+        return value;
+    }
+
+private:
+    std::mutex mutex;
+    unrolled_list<uint64_t, 64> list;
+};
+
+template<typename Queue>
+uint64_t pop_wait(Queue& queue) {
+    while (true) {
+        if (auto value = queue.try_pop()) return *value;
+        std::this_thread::yield();
+    }
+}
+
+// Items per second streamed from one producer to one consumer
+template<typename Queue>
+double throughput() {
+    Queue queue;
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&queue] {
+        for (uint64_t i = 0; i < ThroughputItems; ++i) queue.push(i);
+    });
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < ThroughputItems; ++i) sum += pop_wait(queue);
+    producer.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (sum != ThroughputItems * (ThroughputItems - 1) / 2) std::abort();
+    return ThroughputItems / elapsed.count();
+}
+
+// Mean round trip in nanoseconds through a pair of queues
+template<typename Queue>
+double round_trip() {
+    Queue ping;
+    Queue pong;
+    std::thread echo([&] {
+        for (uint64_t i = 0; i < RoundTrips; ++i) pong.push(pop_wait(ping));
+    });
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < RoundTrips; ++i) {
+        ping.push(i);
+        if (pop_wait(pong) != i) std::abort();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    echo.join();
+    return elapsed.count() / RoundTrips;
+}
+
+} // namespace
+
+int main() {
+    using spsc_queue = spsc_unrolled_queue<uint64_t, 64>;
+    std::cout << "queue                items/s     round_trip_ns\n";
+    std::cout << "mutex+unrolled_list  " << static_cast<long long>(throughput<locked_queue>()) << "  "
+              << round_trip<locked_queue>() << "\n";
+    std::cout << "spsc_unrolled_queue  " << static_cast<long long>(throughput<spsc_queue>()) << "  "
+              << round_trip<spsc_queue>() << "\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <memory>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// Unrolled list that many threads can append to while readers iterate the
+// already published prefix without taking any lock.
+//
+// An appender reserves a slot in the tail node with a fetch-add, constructs
+// the element in place and marks the slot ready. Every node keeps a committed
+// count: the length of its prefix in which all slots are settled. Appenders
+// advance it cooperatively, so whoever fills the last gap publishes the slots
+// behind it. Iterators only read below the committed count, and nodes are
+// never moved or freed before the list itself, so iteration never blocks or
+// retries and never holds up appenders.
+template<typename T, size_t NodeMaxSize = 64, typename Allocator = std::allocator<T>>
+class append_only_unrolled_list {
+private:
+    static constexpr size_t CacheLine = 64;
+
+    enum SlotState : uint8_t { Pending, Ready, Abandoned };
+
+    struct Node {
+        alignas(CacheLine) std::atomic<size_t> reserved; // Slots handed out to appenders
+        alignas(CacheLine) std::atomic<size_t> committed; // Length of the settled prefix
+        std::atomic<size_t> abandoned; // Slots whose constructor threw, a hint for size()
+        std::atomic<Node*> next; // Pointer to the next node
+        std::array<std::atomic<uint8_t>, NodeMaxSize> state; // SlotState of every slot
+        alignas(T) unsigned char storage[NodeMaxSize * sizeof(T)]; // Array of elements
+
+        Node() : reserved(0), committed(0), abandoned(0), next(nullptr) {
+            for (auto& slot : state) slot.store(Pending, std::memory_order_relaxed);
+        }
+
+        ~Node() {
+            for (size_t i = 0; i < NodeMaxSize; ++i) {
+                if (state[i].load(std::memory_order_relaxed) == Ready) data()[i].~T();
+            }
+        }
+
+        T* data() { return reinterpret_cast<T*>(storage); }
+        const T* data() const { return reinterpret_cast<const T*>(storage); }
+
+        // Settle slot index and publish as much of the prefix as is settled
+        void settle(size_t index, SlotState outcome) {
+            state[index].store(outcome, std::memory_order_seq_cst);
+            size_t count = committed.load(std::memory_order_seq_cst);
+            while (count < NodeMaxSize && state[count].load(std::memory_order_seq_cst) != Pending) {
+                if (committed.compare_exchange_weak(count, count + 1, std::memory_order_seq_cst)) ++count;
+            }
+        }
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
+    Node* head;
+    alignas(CacheLine) std::atomic<Node*> tail;
+    NodeAllocator node_allocator;
+
+    Node* create_node() {
+        Node* node = NodeAllocatorTraits::allocate(node_allocator, 1);
+        try {
+            NodeAllocatorTraits::construct(node_allocator, node);
+        } catch (...) {
+            NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroy_node(Node* node) noexcept {
+        NodeAllocatorTraits::destroy(node_allocator, node);
+        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+    }
+
+public:
+    // Forward iterator over the published prefix. It re-reads the committed
+    // counts as it goes, so elements published meanwhile are picked up.
+    class const_iterator {
+    private:
+        const Node* current_node; // Pointer to current node, nullptr at the end
+        size_t current_pos; // Current position in node's element array
+
+        // Move to the first readable slot at or after the current one
+        void skip_unreadable() {
+            while (current_node) {
+                size_t committed = current_node->committed.load(std::memory_order_acquire);
+                while (current_pos < committed &&
+                       current_node->state[current_pos].load(std::memory_order_relaxed) == Abandoned) {
+                    ++current_pos;
+                }
+                if (current_pos < committed) return;
+                if (committed < NodeMaxSize) break; // End of the published prefix
+                current_node = current_node->next.load(std::memory_order_acquire);
+                current_pos = 0;
+            }
+            current_node = nullptr;
+            current_pos = 0;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator(const Node* node = nullptr, size_t pos = 0)
+            : current_node(node), current_pos(pos) {
+            skip_unreadable();
+        }
+
+        reference operator*() const {
+            return current_node->data()[current_pos];
+        }
+
+        pointer operator->() const {
+            return current_node->data() + current_pos;
+        }
+
+        const_iterator& operator++() {
+            ++current_pos;
+            skip_unreadable();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return current_node == other.current_node && current_pos == other.current_pos;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using iterator = const_iterator;
+
+    explicit append_only_unrolled_list(const Allocator& alloc = Allocator())
+        : node_allocator(alloc) {
+        head = create_node();
+        tail.store(head, std::memory_order_relaxed);
+    }
+
+    append_only_unrolled_list(const append_only_unrolled_list&) = delete;
+    append_only_unrolled_list& operator=(const append_only_unrolled_list&) = delete;
+
+    ~append_only_unrolled_list() {
+        Node* node = head;
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            destroy_node(node);
+            node = next;
+        }
+    }
+
+    // Appenders
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    // The returned reference stays valid for the lifetime of the list
+    template<typename... Args>
+    const T& emplace_back(Args&&... args) {
+        while (true) {
+            Node* last = tail.load(std::memory_order_acquire);
+            size_t index = last->reserved.fetch_add(1, std::memory_order_relaxed);
+
+            if (index < NodeMaxSize) {
+                T* slot = last->data() + index;
+                try {
+                    new (slot) T(std::forward<Args>(args)...);
+                } catch (...) {
+                    last->abandoned.fetch_add(1, std::memory_order_relaxed);
+                    last->settle(index, Abandoned);
+                    throw;
+                }
+                last->settle(index, Ready);
+                return *slot;
+            }
+
+            // Tail is full, link a new node unless another appender already did
+            Node* next = last->next.load(std::memory_order_acquire);
+            if (!next) {
+                Node* node = create_node();
+                if (last->next.compare_exchange_strong(next, node, std::memory_order_acq_rel)) {
+                    next = node;
+                } else {
+                    destroy_node(node);
+                }
+            }
+            tail.compare_exchange_strong(last, next, std::memory_order_acq_rel);
+        }
+    }
+
+    // Readers
+    const_iterator begin() const noexcept {
+        return const_iterator(head, 0);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    // Number of published elements, one committed count read per node
+    size_type size() const noexcept {
+        size_type total = 0;
+        for (const Node* node = head; node; node = node->next.load(std::memory_order_acquire)) {
+            size_t committed = node->committed.load(std::memory_order_acquire);
+            total += committed;
+            if (node->abandoned.load(std::memory_order_relaxed) != 0) {
+                for (size_t i = 0; i < committed; ++i) {
+                    if (node->state[i].load(std::memory_order_relaxed) == Abandoned) --total;
+                }
+            }
+            if (committed < NodeMaxSize) break;
+        }
+        return total;
+    }
+
+    bool empty() const noexcept {
+        return begin() == end();
+    }
+};
@@ -0,0 +1,440 @@
+#pragma once
+
+#include <memory>
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "unrolled_list_locate.h"
+
+// Unrolled list of integers that keeps nodes which have not been modified
+// recently compressed.
+//
+// Only the most recently modified nodes (hot_nodes of them) keep a plain
+// element block. When another node is modified the least recently modified
+// hot node is delta encoded and bit-packed against the smallest delta of the
+// node (frame of reference), which shrinks sorted or slowly changing series
+// such as timestamps and counters to a few bits per element and decodes
+// without branches. Reads never make a node hot: they decode cold nodes
+// a whole block at a time, into the iterator or into the buffer handed to
+// for_each_block, so scans run over plain arrays.
+template<std::integral T, size_t NodeMaxSize = 128, typename Allocator = std::allocator<T>>
+    requires (!std::same_as<T, bool>)
+class compressed_unrolled_list {
+private:
+    using Unsigned = std::make_unsigned_t<T>;
+    using ByteAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<unsigned char>;
+    using ByteAllocatorTraits = std::allocator_traits<ByteAllocator>;
+    using BlockAllocatorTraits = std::allocator_traits<Allocator>;
+
+    struct Node {
+        Node* next; // Pointer to the next node
+        Node* prev; // Pointer to the previous node
+        size_t size; // Current number of elements
+        T* data; // Plain element block, nullptr while compressed
+        unsigned char* packed; // Encoded elements while compressed
+        size_t packed_size; // Bytes in packed
+        bool hot; // Linked in the hot list
+        Node* hot_prev; // More recently modified hot node
+        Node* hot_next; // Less recently modified hot node
+
+        Node() : next(nullptr), prev(nullptr), size(0), data(nullptr), packed(nullptr), packed_size(0),
+                 hot(false), hot_prev(nullptr), hot_next(nullptr) {}
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
+    Node* head;
+    Node* tail;
+    size_t size_;
+    size_t hot_limit;
+    size_t hot_count;
+    Node* hot_head; // Most recently modified hot node
+    Node* hot_tail; // Least recently modified hot node
+    Allocator block_allocator;
+    ByteAllocator byte_allocator;
+    NodeAllocator node_allocator;
+
+    // Packed block: the first element, the reference delta, the bit width,
+    // then every further delta minus the reference in width bits. Eight bytes
+    // of padding let decode load a whole word at any bit position.
+    static constexpr size_t PackedHeader = 2 * sizeof(Unsigned) + 1;
+    static constexpr size_t MaxWidth = 56;
+    static constexpr size_t MaxPackedSize = PackedHeader + NodeMaxSize * sizeof(T) + 8;
+
+    static uint64_t load_word(const unsigned char* in) noexcept {
+        uint64_t word;
+        std::memcpy(&word, in, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) word = std::byteswap(word);
+        return word;
+    }
+
+    static void store_word(unsigned char* out, uint64_t word) noexcept {
+        if constexpr (std::endian::native == std::endian::big) word = std::byteswap(word);
+        std::memcpy(out, &word, sizeof(word));
+    }
+
+    // Encode count elements into out, returns the bytes written or 0 if the
+    // deltas are too wide to pack
+    static size_t encode(const T* values, size_t count, unsigned char* out) noexcept {
+        using Signed = std::make_signed_t<T>;
+        Unsigned first = Unsigned(values[0]);
+        Unsigned reference = 0;
+        if (count > 1) {
+            Signed low = Signed(Unsigned(Unsigned(values[1]) - first));
+            for (size_t i = 2; i < count; ++i) {
+                low = std::min(low, Signed(Unsigned(Unsigned(values[i]) - Unsigned(values[i - 1]))));
+            }
+            reference = Unsigned(low);
+        }
+        Unsigned spread = 0;
+        for (size_t i = 1; i < count; ++i) {
+            spread |= Unsigned(Unsigned(Unsigned(values[i]) - Unsigned(values[i - 1])) - reference);
+        }
+        size_t width = size_t(std::bit_width(spread));
+        if (width > MaxWidth) return 0;
+
+        std::memcpy(out, &first, sizeof(Unsigned));
+        std::memcpy(out + sizeof(Unsigned), &reference, sizeof(Unsigned));
+        out[2 * sizeof(Unsigned)] = static_cast<unsigned char>(width);
+        unsigned char* bits = out + PackedHeader;
+        size_t bytes = ((count - 1) * width + 7) / 8;
+        std::memset(bits, 0, bytes + 8);
+        for (size_t i = 1; i < count; ++i) {
+            uint64_t delta = Unsigned(Unsigned(Unsigned(values[i]) - Unsigned(values[i - 1])) - reference);
+            size_t pos = (i - 1) * width;
+            store_word(bits + pos / 8, load_word(bits + pos / 8) | (delta << (pos % 8)));
+        }
+        return PackedHeader + bytes + 8;
+    }
+
+    // Decode the first count elements of a packed block into out
+    static void decode(const unsigned char* in, size_t count, T* out) noexcept {
+        Unsigned prev;
+        Unsigned reference;
+        std::memcpy(&prev, in, sizeof(Unsigned));
+        std::memcpy(&reference, in + sizeof(Unsigned), sizeof(Unsigned));
+        size_t width = in[2 * sizeof(Unsigned)];
+        const unsigned char* bits = in + PackedHeader;
+        uint64_t mask = (uint64_t(1) << width) - 1;
+
+        out[0] = T(prev);
+        for (size_t i = 1; i < count; ++i) {
+            size_t pos = (i - 1) * width;
+            uint64_t delta = (load_word(bits + pos / 8) >> (pos % 8)) & mask;
+            prev = Unsigned(prev + Unsigned(delta) + reference);
+            out[i] = T(prev);
+        }
+    }
+
+    void hot_unlink(Node* node) noexcept {
+        if (node->hot_prev) node->hot_prev->hot_next = node->hot_next; else hot_head = node->hot_next;
+        if (node->hot_next) node->hot_next->hot_prev = node->hot_prev; else hot_tail = node->hot_prev;
+        node->hot_prev = nullptr;
+        node->hot_next = nullptr;
+        node->hot = false;
+        --hot_count;
+    }
+
+    void hot_push_front(Node* node) noexcept {
+        node->hot_next = hot_head;
+        if (hot_head) hot_head->hot_prev = node; else hot_tail = node;
+        hot_head = node;
+        node->hot = true;
+        ++hot_count;
+    }
+
+    // Replace the plain block of a node by its encoding if that is smaller
+    void compress(Node* node) {
+        if (!node->data || node->size == 0) return;
+        unsigned char scratch[MaxPackedSize];
+        size_t bytes = encode(node->data, node->size, scratch);
+        if (bytes == 0 || bytes >= NodeMaxSize * sizeof(T)) return;
+
+        unsigned char* packed = ByteAllocatorTraits::allocate(byte_allocator, bytes);
+        std::memcpy(packed, scratch, bytes);
+        BlockAllocatorTraits::deallocate(block_allocator, node->data, NodeMaxSize);
+        node->data = nullptr;
+        node->packed = packed;
+        node->packed_size = bytes;
+    }
+
+    // Give the node a plain block and make it the most recently modified
+    T* make_hot(Node* node) {
+        if (!node->data) {
+            T* data = BlockAllocatorTraits::allocate(block_allocator, NodeMaxSize);
+            decode(node->packed, node->size, data);
+            ByteAllocatorTraits::deallocate(byte_allocator, node->packed, node->packed_size);
+            node->packed = nullptr;
+            node->packed_size = 0;
+            node->data = data;
+        }
+        if (node->hot) {
+            if (node == hot_head) return node->data;
+            hot_unlink(node);
+        }
+        hot_push_front(node);
+        while (hot_count > hot_limit) {
+            Node* coldest = hot_tail;
+            hot_unlink(coldest);
+            compress(coldest);
+        }
+        return node->data;
+    }
+
+    // Plain elements of a node, decoded into buffer if it is compressed
+    static const T* elements(const Node* node, T* buffer) noexcept {
+        if (node->data) return node->data;
+        decode(node->packed, node->size, buffer);
+        return buffer;
+    }
+
+    // Create a node with a plain block linked between prev and next, the
+    // caller makes it hot
+    Node* create_node(Node* prev, Node* next) {
+        Node* node = NodeAllocatorTraits::allocate(node_allocator, 1);
+        NodeAllocatorTraits::construct(node_allocator, node);
+        try {
+            node->data = BlockAllocatorTraits::allocate(block_allocator, NodeMaxSize);
+        } catch (...) {
+            NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+            throw;
+        }
+        node->prev = prev;
+        node->next = next;
+        if (prev) prev->next = node; else head = node;
+        if (next) next->prev = node; else tail = node;
+        return node;
+    }
+
+    void destroy_node(Node* node) noexcept {
+        if (node->prev) node->prev->next = node->next; else head = node->next;
+        if (node->next) node->next->prev = node->prev; else tail = node->prev;
+        if (node->hot) hot_unlink(node);
+        if (node->data) BlockAllocatorTraits::deallocate(block_allocator, node->data, NodeMaxSize);
+        if (node->packed) ByteAllocatorTraits::deallocate(byte_allocator, node->packed, node->packed_size);
+        NodeAllocatorTraits::destroy(node_allocator, node);
+        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+    }
+
+    // Node and position of the element at index, index == size maps to the end
+    // of the tail. Sizes are kept in the headers, so cold nodes stay packed.
+    std::pair<Node*, size_t> locate(size_t index) const noexcept {
+        return unrolled_list_locate(head, tail, size_, index,
+            [](const Node* node) { return node->size; }, [](const Node* node) { return node->next; });
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+
+    // Forward iterator decoding a compressed node once when it reaches it.
+    // Copies share the decoded block.
+    class const_iterator {
+    private:
+        const Node* current_node; // Pointer to current node, nullptr at the end
+        size_t current_pos; // Current position in node's element array
+        const T* current_data; // Plain elements of current_node
+        std::shared_ptr<T[]> buffer; // Decoded block of a compressed node
+
+        void enter(const Node* node) {
+            current_node = node;
+            current_pos = 0;
+            current_data = nullptr;
+            if (!node) return;
+            // Copies still read the block in buffer, decode into a fresh one
+            if (!node->data && (!buffer || buffer.use_count() > 1)) buffer.reset(new T[NodeMaxSize]);
+            current_data = elements(node, buffer.get());
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        explicit const_iterator(const Node* node = nullptr) {
+            enter(node);
+        }
+
+        reference operator*() const {
+            return current_data[current_pos];
+        }
+
+        pointer operator->() const {
+            return current_data + current_pos;
+        }
+
+        const_iterator& operator++() {
+            if (++current_pos == current_node->size) enter(current_node->next);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return current_node == other.current_node && current_pos == other.current_pos;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Up to hot_nodes recently modified nodes stay uncompressed
+    explicit compressed_unrolled_list(size_type hot_nodes = 4, const Allocator& alloc = Allocator())
+        : head(nullptr), tail(nullptr), size_(0), hot_limit(std::max<size_type>(hot_nodes, 1)), hot_count(0),
+          hot_head(nullptr), hot_tail(nullptr), block_allocator(alloc), byte_allocator(alloc),
+          node_allocator(alloc) {}
+
+    compressed_unrolled_list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+        : compressed_unrolled_list(4, alloc) {
+        for (T value : init) push_back(value);
+    }
+
+    compressed_unrolled_list(const compressed_unrolled_list&) = delete;
+    compressed_unrolled_list& operator=(const compressed_unrolled_list&) = delete;
+
+    ~compressed_unrolled_list() {
+        clear();
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return block_allocator;
+    }
+
+    // Element access, by value since compressed elements have no address
+    T operator[](size_type pos) const {
+        auto [node, offset] = locate(pos);
+        if (node->data) return node->data[offset];
+        T prefix[NodeMaxSize];
+        decode(node->packed, offset + 1, prefix);
+        return prefix[offset];
+    }
+
+    T at(size_type pos) const {
+        if (pos >= size_) throw std::out_of_range("compressed_unrolled_list::at");
+        return (*this)[pos];
+    }
+
+    T front() const { return (*this)[0]; }
+    T back() const { return (*this)[size_ - 1]; }
+
+    // Replace the element at pos, its node becomes hot
+    void set(size_type pos, T value) {
+        auto [node, offset] = locate(pos);
+        make_hot(node)[offset] = value;
+    }
+
+    // Iterators
+    const_iterator begin() const { return const_iterator(head); }
+    const_iterator end() const noexcept { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Segmented scan: calls f with the plain elements of every node in order,
+    // decoding compressed nodes into one reused buffer
+    template<typename F>
+    void for_each_block(F f) const {
+        T buffer[NodeMaxSize];
+        for (const Node* node = head; node; node = node->next) {
+            f(std::span<const T>(elements(node, buffer), node->size));
+        }
+    }
+
+    // Size
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+
+    // Memory
+    // Bytes held by element blocks and encodings, excluding node headers
+    size_type memory_usage() const noexcept {
+        size_type bytes = 0;
+        for (const Node* node = head; node; node = node->next) {
+            bytes += node->data ? NodeMaxSize * sizeof(T) : node->packed_size;
+        }
+        return bytes;
+    }
+
+    size_type hot_nodes() const noexcept { return hot_count; }
+
+    // Compress every node now, e.g. before the list is only read for a while
+    void compress_all() {
+        while (hot_tail) {
+            Node* node = hot_tail;
+            hot_unlink(node);
+            compress(node);
+        }
+    }
+
+    // Modifiers
+    void clear() noexcept {
+        while (tail) destroy_node(tail);
+        size_ = 0;
+    }
+
+    void push_back(T value) { insert(size_, value); }
+    void push_front(T value) { insert(0, value); }
+
+    void pop_back() { erase(size_ - 1); }
+    void pop_front() { erase(0); }
+
+    // Insert before the element at pos, pos == size() appends
+    void insert(size_type pos, T value) {
+        auto [node, offset] = locate(pos);
+        if (!node || (pos == size_ && node->size == NodeMaxSize)) {
+            // A full tail is not split for an append, which would keep two
+            // half-full hot blocks where one full block can be packed
+            node = create_node(tail, nullptr);
+            offset = 0;
+        } else if (node->size == NodeMaxSize) {
+            // Unpack the full node if it is cold, then move its upper half
+            // into a new node after it, which starts out hot as well
+            T* data = make_hot(node);
+            size_t half = NodeMaxSize / 2;
+            Node* back = create_node(node, node->next);
+            std::memcpy(back->data, data + half, (node->size - half) * sizeof(T));
+            back->size = node->size - half;
+            node->size = half;
+            make_hot(back);
+            if (offset > half) {
+                node = back;
+                offset -= half;
+            }
+        }
+
+        T* data = make_hot(node);
+        std::memmove(data + offset + 1, data + offset, (node->size - offset) * sizeof(T));
+        data[offset] = value;
+        ++node->size;
+        ++size_;
+    }
+
+    void erase(size_type pos) {
+        auto [node, offset] = locate(pos);
+        if (node->size == 1) {
+            destroy_node(node);
+        } else {
+            T* data = make_hot(node);
+            std::memmove(data + offset, data + offset + 1, (node->size - offset - 1) * sizeof(T));
+            --node->size;
+        }
+        --size_;
+    }
+};
@@ -0,0 +1,460 @@
+#pragma once
+
+#include <memory>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Unrolled list that allows several threads to insert, erase and read in
+// different regions at the same time.
+//
+// Nodes are kept in a singly linked chain behind a sentinel and carry their own
+// reader/writer lock. Traversals use hand-over-hand locking in chain order with
+// shared locks; writers only lock the node they change and its predecessor
+// exclusively, so they do not hold up the threads walking behind them. push_back
+// goes straight to the tail node, which is never unlinked, so it does not have
+// to walk the chain. Indices are resolved while the walk passes each node, so
+// writers elsewhere in the list may shift them.
+//
+// The nodes are not unrolled_list's. Those are doubly linked, and unlinking
+// one would also need its successor's lock, taken against the direction the
+// traversals lock in. Elements are stored inline rather than in a separate
+// block, so a node is one allocation guarded by one lock. Full nodes split in
+// half like unrolled_list's, but towards the front, and after an erase a node
+// is folded into its predecessor once the two fill at most half a node.
+template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>>
+class concurrent_unrolled_list {
+private:
+    struct Node {
+        mutable std::shared_mutex mutex; // Guards size, next and the elements
+        size_t size; // Current number of elements
+        Node* next; // Pointer to the next node
+        alignas(T) unsigned char storage[NodeMaxSize * sizeof(T)]; // Array of elements
+
+        Node() : size(0), next(nullptr) {}
+
+        ~Node() {
+            for (size_t i = 0; i < size; ++i) {
+                data()[i].~T();
+            }
+        }
+
+        T* data() { return reinterpret_cast<T*>(storage); }
+        const T* data() const { return reinterpret_cast<const T*>(storage); }
+
+        bool is_full() const { return size == NodeMaxSize; }
+
+        // Open a gap at pos by moving the tail of the block one slot up
+        void open_gap(size_t pos) {
+            for (size_t i = size; i > pos; --i) {
+                new (data() + i) T(std::move(data()[i - 1]));
+                data()[i - 1].~T();
+            }
+        }
+
+        // Close the gap left by a destroyed element at pos
+        void close_gap(size_t pos) {
+            for (size_t i = pos + 1; i < size; ++i) {
+                new (data() + i - 1) T(std::move(data()[i]));
+                data()[i].~T();
+            }
+        }
+
+        // Move all elements of other to the end of this node
+        void absorb(Node& other) {
+            for (size_t i = 0; i < other.size; ++i) {
+                new (data() + size + i) T(std::move(other.data()[i]));
+                other.data()[i].~T();
+            }
+            size += other.size;
+            other.size = 0;
+        }
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
+    using WriteLock = std::unique_lock<std::shared_mutex>;
+    using ReadLock = std::shared_lock<std::shared_mutex>;
+
+    // Size is tracked in per-thread stripes to keep writers off a shared cache line
+    static constexpr size_t SizeStripes = 16;
+
+    struct alignas(64) SizeStripe {
+        std::atomic<std::ptrdiff_t> value{0};
+    };
+
+    Node sentinel; // Never holds elements, every traversal starts here
+    alignas(64) std::mutex tail_mutex; // Serializes push_back
+    Node* tail; // Last node, only ever replaced under tail_mutex and its own lock
+    std::array<SizeStripe, SizeStripes> size_stripes;
+    NodeAllocator node_allocator;
+
+    Node* create_node() {
+        Node* node = NodeAllocatorTraits::allocate(node_allocator, 1);
+        try {
+            NodeAllocatorTraits::construct(node_allocator, node);
+        } catch (...) {
+            NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroy_node(Node* node) noexcept {
+        NodeAllocatorTraits::destroy(node_allocator, node);
+        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+    }
+
+    void count(std::ptrdiff_t delta) noexcept {
+        thread_local const size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % SizeStripes;
+        size_stripes[stripe].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // Split a full node by moving its first half into a new node linked in
+    // front of it. Both prev and node must be locked exclusively. Splitting
+    // towards the front keeps the tail node in place.
+    Node* split_front(Node* prev, Node* node) {
+        Node* front = create_node();
+        size_t half = NodeMaxSize / 2;
+        for (size_t i = 0; i < half; ++i) {
+            new (front->data() + i) T(std::move(node->data()[i]));
+            node->data()[i].~T();
+        }
+        front->size = half;
+        for (size_t i = half; i < node->size; ++i) {
+            new (node->data() + i - half) T(std::move(node->data()[i]));
+            node->data()[i].~T();
+        }
+        node->size -= half;
+
+        front->next = node;
+        prev->next = front;
+        return front;
+    }
+
+    // Unlink node after prev once it is empty or small enough to fold into
+    // prev. Both must be locked exclusively, node_lock is released before
+    // the node is freed. Only the thread holding prev can reach node, so
+    // nobody else can be waiting for it. The tail is never unlinked.
+    void maybe_unlink(Node* prev, Node* node, WriteLock& node_lock) {
+        if (!node->next) return;
+
+        if (node->size == 0) {
+            prev->next = node->next;
+        } else if (prev != &sentinel && prev->size + node->size <= NodeMaxSize / 2) {
+            prev->absorb(*node);
+            prev->next = node->next;
+        } else {
+            return;
+        }
+        node_lock.unlock();
+        destroy_node(node);
+    }
+
+    // Commits an erase_if pass over one node on every exit. Slots in
+    // [kept, read) are destroyed or moved from; if pred or a move throws, the
+    // unvisited elements from read on are slid down behind the kept ones, so
+    // the node never holds a dead slot below its size and the count matches.
+    struct compaction_guard {
+        concurrent_unrolled_list& list;
+        Node* node;
+        size_t& kept;
+        size_t& read;
+        size_t& removed;
+
+        ~compaction_guard() {
+            size_t rest = node->size - read;
+            if (kept != read) {
+                for (size_t i = 0; i < rest; ++i) {
+                    new (node->data() + kept + i) T(std::move(node->data()[read + i]));
+                    node->data()[read + i].~T();
+                }
+            }
+            removed += read - kept;
+            list.count(-static_cast<std::ptrdiff_t>(read - kept));
+            node->size = kept + rest;
+        }
+    };
+
+    // Lock the node holding index and its predecessor exclusively, leaving
+    // index relative to node. An insert position may also be one past the last
+    // element of a node. The walk takes shared locks; prev is relocked
+    // exclusively while its own predecessor is still held shared, which keeps
+    // prev linked in the meantime.
+    void lock_position(size_t& index, bool insert, Node*& prev, WriteLock& prev_lock,
+                       Node*& node, WriteLock& node_lock) {
+        auto past = [insert](const Node* node, size_t index) {
+            return insert ? index > node->size : index >= node->size;
+        };
+
+        ReadLock anchor_lock; // Predecessor of prev, if prev is not the sentinel
+        prev = &sentinel;
+        ReadLock shared_prev(prev->mutex);
+        node = prev->next;
+        ReadLock shared_node(node->mutex);
+        while (past(node, index) && node->next) {
+            index -= node->size;
+            anchor_lock = std::move(shared_prev);
+            prev = node;
+            shared_prev = std::move(shared_node);
+            node = node->next;
+            shared_node = ReadLock(node->mutex);
+        }
+        shared_node.unlock();
+        shared_prev.unlock();
+
+        // prev always has a successor, only nodes with one are ever unlinked
+        prev_lock = WriteLock(prev->mutex);
+        if (anchor_lock.owns_lock()) anchor_lock.unlock();
+        node = prev->next;
+        node_lock = WriteLock(node->mutex);
+
+        // Writers that got in between may have moved elements around
+        while (past(node, index) && node->next) {
+            index -= node->size;
+            prev = node;
+            prev_lock = std::move(node_lock);
+            node = node->next;
+            node_lock = WriteLock(node->mutex);
+        }
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+
+    explicit concurrent_unrolled_list(const Allocator& alloc = Allocator())
+        : node_allocator(alloc) {
+        tail = create_node();
+        sentinel.next = tail;
+    }
+
+    concurrent_unrolled_list(const concurrent_unrolled_list&) = delete;
+    concurrent_unrolled_list& operator=(const concurrent_unrolled_list&) = delete;
+
+    ~concurrent_unrolled_list() {
+        Node* node = sentinel.next;
+        while (node) {
+            Node* next = node->next;
+            destroy_node(node);
+            node = next;
+        }
+    }
+
+    // Size
+    // Sum of the per-thread stripes, exact once all writers are quiescent
+    size_type size() const noexcept {
+        std::ptrdiff_t total = 0;
+        for (const SizeStripe& stripe : size_stripes) {
+            total += stripe.value.load(std::memory_order_relaxed);
+        }
+        return total > 0 ? static_cast<size_type>(total) : 0;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Modifiers
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template<typename... Args>
+    void emplace_back(Args&&... args) {
+        std::lock_guard<std::mutex> guard(tail_mutex);
+        WriteLock tail_lock(tail->mutex);
+
+        if (tail->is_full()) {
+            Node* node = create_node();
+            try {
+                new (node->data()) T(std::forward<Args>(args)...);
+            } catch (...) {
+                destroy_node(node);
+                throw;
+            }
+            node->size = 1;
+            tail->next = node;
+            tail = node;
+        } else {
+            new (tail->data() + tail->size) T(std::forward<Args>(args)...);
+            ++tail->size;
+        }
+        count(1);
+    }
+
+    void push_front(const T& value) {
+        emplace(0, value);
+    }
+
+    void push_front(T&& value) {
+        emplace(0, std::move(value));
+    }
+
+    void insert(size_type index, const T& value) {
+        emplace(index, value);
+    }
+
+    void insert(size_type index, T&& value) {
+        emplace(index, std::move(value));
+    }
+
+    // Emplace before the element at index, or at the end if index is past it
+    template<typename... Args>
+    void emplace(size_type index, Args&&... args) {
+        T value(std::forward<Args>(args)...);
+
+        Node* prev;
+        Node* node;
+        WriteLock prev_lock;
+        WriteLock node_lock;
+        lock_position(index, true, prev, prev_lock, node, node_lock);
+        if (index > node->size) index = node->size;
+
+        if (node->is_full()) {
+            Node* front = split_front(prev, node);
+            if (index <= front->size) {
+                node = front;
+            } else {
+                index -= front->size;
+            }
+        }
+
+        node->open_gap(index);
+        new (node->data() + index) T(std::move(value));
+        ++node->size;
+        count(1);
+    }
+
+    // Erase the element at index, returns false if there is none
+    bool erase(size_type index) {
+        return extract(index).has_value();
+    }
+
+    // Remove the element at index and return it
+    std::optional<T> extract(size_type index) {
+        Node* prev;
+        Node* node;
+        WriteLock prev_lock;
+        WriteLock node_lock;
+        lock_position(index, false, prev, prev_lock, node, node_lock);
+        if (index >= node->size) return std::nullopt;
+
+        std::optional<T> result(std::move(node->data()[index]));
+        node->data()[index].~T();
+        node->close_gap(index);
+        --node->size;
+        count(-1);
+
+        maybe_unlink(prev, node, node_lock);
+        return result;
+    }
+
+    std::optional<T> pop_front() {
+        return extract(0);
+    }
+
+    // Remove every element matching pred, returns the number removed
+    template<typename Pred>
+    size_type erase_if(Pred pred) {
+        size_type removed = 0;
+        Node* prev = &sentinel;
+        WriteLock prev_lock(prev->mutex);
+        Node* node = prev->next;
+        WriteLock node_lock(node->mutex);
+
+        while (true) {
+            {
+                size_t kept = 0;
+                size_t i = 0;
+                compaction_guard guard{*this, node, kept, i, removed};
+                for (; i < node->size; ++i) {
+                    T* value = node->data() + i;
+                    if (pred(std::as_const(*value))) {
+                        value->~T();
+                        continue;
+                    }
+                    if (kept != i) {
+                        new (node->data() + kept) T(std::move(*value));
+                        value->~T();
+                    }
+                    ++kept;
+                }
+            }
+
+            Node* next = node->next;
+            if (!next) break;
+
+            maybe_unlink(prev, node, node_lock);
+            if (node_lock.owns_lock()) {
+                prev = node;
+                prev_lock = std::move(node_lock);
+            }
+            node = next;
+            node_lock = WriteLock(node->mutex);
+        }
+
+        return removed;
+    }
+
+    void clear() {
+        erase_if([](const T&) { return true; });
+    }
+
+    // Element access
+    // Copy of the element at index, if there is one
+    std::optional<T> get(size_type index) const {
+        const Node* node = &sentinel;
+        ReadLock lock(node->mutex);
+        while ((node = node->next)) {
+            ReadLock next_lock(node->mutex);
+            lock = std::move(next_lock);
+            if (index < node->size) return node->data()[index];
+            index -= node->size;
+        }
+        return std::nullopt;
+    }
+
+    // Call f on every element in order under shared node locks
+    template<typename F>
+    void for_each(F f) const {
+        const Node* node = &sentinel;
+        ReadLock lock(node->mutex);
+        while ((node = node->next)) {
+            ReadLock next_lock(node->mutex);
+            lock = std::move(next_lock);
+            for (size_t i = 0; i < node->size; ++i) {
+                f(node->data()[i]);
+            }
+        }
+    }
+
+    template<typename Pred>
+    std::optional<T> find_if(Pred pred) const {
+        const Node* node = &sentinel;
+        ReadLock lock(node->mutex);
+        while ((node = node->next)) {
+            ReadLock next_lock(node->mutex);
+            lock = std::move(next_lock);
+            for (size_t i = 0; i < node->size; ++i) {
+                if (pred(node->data()[i])) return node->data()[i];
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool contains(const T& value) const {
+        return find_if([&value](const T& item) { return item == value; }).has_value();
+    }
+};
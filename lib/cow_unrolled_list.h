@@ -0,0 +1,462 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Unrolled list with O(1) snapshots for readers that scan while the owner
+// keeps mutating.
+//
+// Nodes are reference counted and addressed through a two level spine: a
+// reference counted vector of chunks, each a reference counted vector of up to
+// ChunkMaxNodes node pointers. snapshot() only shares the spine. The first
+// write after a snapshot copies the spine's chunk pointers, the chunk holding
+// the node and the node itself if a snapshot still references them
+// (copy-on-write at node granularity), so it costs O(nodes / ChunkMaxNodes +
+// ChunkMaxNodes + NodeMaxSize) rather than a copy of every node pointer. A
+// node is freed when the last chunk referencing it dies. Snapshots may be read
+// from other threads; the list itself has a single owner.
+template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>>
+class cow_unrolled_list {
+private:
+    struct Node {
+        size_t size; // Current number of elements
+        alignas(T) unsigned char storage[NodeMaxSize * sizeof(T)]; // Array of elements
+
+        Node() : size(0) {}
+
+        // Copy made when a shared node is about to be modified
+        Node(const Node& other) : size(0) {
+            try {
+                for (; size < other.size; ++size) {
+                    new (data() + size) T(other.data()[size]);
+                }
+            } catch (...) {
+                destroy();
+                throw;
+            }
+        }
+
+        ~Node() {
+            destroy();
+        }
+
+        T* data() { return reinterpret_cast<T*>(storage); }
+        const T* data() const { return reinterpret_cast<const T*>(storage); }
+
+        bool is_full() const { return size == NodeMaxSize; }
+
+        void destroy() {
+            for (size_t i = 0; i < size; ++i) {
+                data()[i].~T();
+            }
+            size = 0;
+        }
+
+        template<typename... Args>
+        void emplace(size_t pos, Args&&... args) {
+            T value(std::forward<Args>(args)...);
+            for (size_t i = size; i > pos; --i) {
+                new (data() + i) T(std::move(data()[i - 1]));
+                data()[i - 1].~T();
+            }
+            new (data() + pos) T(std::move(value));
+            ++size;
+        }
+
+        void erase(size_t pos) {
+            data()[pos].~T();
+            for (size_t i = pos + 1; i < size; ++i) {
+                new (data() + i - 1) T(std::move(data()[i]));
+                data()[i].~T();
+            }
+            --size;
+        }
+    };
+
+    using NodePtr = std::shared_ptr<Node>;
+
+    static constexpr size_t ChunkMaxNodes = 64;
+
+    using NodePtrAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<NodePtr>;
+
+    struct Chunk {
+        std::vector<NodePtr, NodePtrAllocator> nodes; // Consecutive nodes, never empty
+        size_t size = 0; // Number of elements in them
+
+        explicit Chunk(const NodePtrAllocator& alloc) : nodes(alloc) {}
+    };
+
+    using ChunkPtr = std::shared_ptr<Chunk>;
+    using ChunkPtrAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ChunkPtr>;
+
+    struct Spine {
+        std::vector<ChunkPtr, ChunkPtrAllocator> chunks; // Chunks in list order
+        size_t size = 0; // Total number of elements
+
+        explicit Spine(const ChunkPtrAllocator& alloc) : chunks(alloc) {}
+    };
+
+    // Position of an element: chunk, node in the chunk and offset in the node
+    struct Location {
+        size_t chunk;
+        size_t node;
+        size_t offset;
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using ChunkAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Chunk>;
+    using SpineAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Spine>;
+
+    std::shared_ptr<Spine> spine;
+    Allocator allocator;
+
+    // Readers only ever drop references, so a count of one seen by the owner
+    // means nobody else can reach the object. The fence pairs with the
+    // release in the reader's decrement before the owner writes to it.
+    template<typename Ptr>
+    static bool is_unique(const Ptr& ptr) {
+        if (ptr.use_count() != 1) return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    Spine& own_spine() {
+        if (!spine) {
+            spine = std::allocate_shared<Spine>(SpineAllocator(allocator), ChunkPtrAllocator(allocator));
+        } else if (!is_unique(spine)) {
+            spine = std::allocate_shared<Spine>(SpineAllocator(allocator), *spine);
+        }
+        return *spine;
+    }
+
+    Chunk& own_chunk(Spine& owned, size_t index) {
+        ChunkPtr& chunk = owned.chunks[index];
+        if (!is_unique(chunk)) {
+            chunk = std::allocate_shared<Chunk>(ChunkAllocator(allocator), *chunk);
+        }
+        return *chunk;
+    }
+
+    Node& own_node(Chunk& owned, size_t index) {
+        NodePtr& node = owned.nodes[index];
+        if (!is_unique(node)) {
+            node = std::allocate_shared<Node>(NodeAllocator(allocator), *node);
+        }
+        return *node;
+    }
+
+    NodePtr create_node() {
+        return std::allocate_shared<Node>(NodeAllocator(allocator));
+    }
+
+    ChunkPtr create_chunk() {
+        return std::allocate_shared<Chunk>(ChunkAllocator(allocator), NodePtrAllocator(allocator));
+    }
+
+    // Location of the element at index < size(). Positions in the last node,
+    // e.g. for pop_back, are found without walking the spine; other positions
+    // skip whole chunks before walking the nodes of one.
+    Location locate(size_t index) const {
+        const Chunk& last_chunk = *spine->chunks.back();
+        size_t last_start = spine->size - last_chunk.nodes.back()->size;
+        if (index >= last_start) {
+            return {spine->chunks.size() - 1, last_chunk.nodes.size() - 1, index - last_start};
+        }
+        size_t chunk = 0;
+        for (; index >= spine->chunks[chunk]->size; ++chunk) {
+            index -= spine->chunks[chunk]->size;
+        }
+        const auto& nodes = spine->chunks[chunk]->nodes;
+        size_t node = 0;
+        for (; index >= nodes[node]->size; ++node) {
+            index -= nodes[node]->size;
+        }
+        return {chunk, node, index};
+    }
+
+    // Split a full chunk in halves, only node pointers are copied, so the
+    // list is unchanged if this throws
+    void split_chunk(Spine& owned, size_t index) {
+        owned.chunks.reserve(owned.chunks.size() + 1);
+        const Chunk& full = *owned.chunks[index];
+        size_t half = full.nodes.size() / 2;
+        ChunkPtr front = create_chunk();
+        ChunkPtr back = create_chunk();
+        front->nodes.assign(full.nodes.begin(), full.nodes.begin() + half);
+        back->nodes.assign(full.nodes.begin() + half, full.nodes.end());
+        for (const NodePtr& node : front->nodes) front->size += node->size;
+        back->size = full.size - front->size;
+        owned.chunks[index] = std::move(front);
+        owned.chunks.insert(owned.chunks.begin() + index + 1, std::move(back));
+    }
+
+public:
+    // Forward iterator over a spine. Iterators of the list are invalidated by
+    // any mutation, iterators of a snapshot stay valid as long as it lives.
+    class const_iterator {
+    private:
+        const Spine* spine; // Spine being iterated
+        size_t chunk_index; // Current chunk in the spine
+        size_t node_index; // Current node in the chunk
+        size_t current_pos; // Current position in node's element array
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator(const Spine* spine = nullptr, size_t chunk = 0, size_t node = 0, size_t pos = 0)
+            : spine(spine), chunk_index(chunk), node_index(node), current_pos(pos) {}
+
+        reference operator*() const {
+            return spine->chunks[chunk_index]->nodes[node_index]->data()[current_pos];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        const_iterator& operator++() {
+            const auto& nodes = spine->chunks[chunk_index]->nodes;
+            if (++current_pos == nodes[node_index]->size) {
+                current_pos = 0;
+                if (++node_index == nodes.size()) {
+                    ++chunk_index;
+                    node_index = 0;
+                }
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return chunk_index == other.chunk_index && node_index == other.node_index &&
+                   current_pos == other.current_pos;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Immutable view of the list at the time it was taken
+    class snapshot_type {
+    private:
+        std::shared_ptr<const Spine> spine;
+
+        friend class cow_unrolled_list;
+
+        explicit snapshot_type(std::shared_ptr<const Spine> spine) : spine(std::move(spine)) {}
+
+    public:
+        snapshot_type() = default;
+
+        size_t size() const noexcept { return spine ? spine->size : 0; }
+        bool empty() const noexcept { return size() == 0; }
+
+        const_iterator begin() const noexcept { return const_iterator(spine.get()); }
+        const_iterator end() const noexcept {
+            return const_iterator(spine.get(), spine ? spine->chunks.size() : 0);
+        }
+    };
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    cow_unrolled_list() = default;
+
+    explicit cow_unrolled_list(const Allocator& alloc) : allocator(alloc) {}
+
+    cow_unrolled_list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+        : allocator(alloc) {
+        for (const auto& item : init) push_back(item);
+    }
+
+    // Copies share every node until either side modifies it
+    cow_unrolled_list(const cow_unrolled_list& other) = default;
+    cow_unrolled_list(cow_unrolled_list&& other) noexcept = default;
+    cow_unrolled_list& operator=(const cow_unrolled_list& other) = default;
+    cow_unrolled_list& operator=(cow_unrolled_list&& other) noexcept = default;
+
+    allocator_type get_allocator() const noexcept {
+        return allocator;
+    }
+
+    // O(1) read-only view sharing all nodes with the list
+    snapshot_type snapshot() const {
+        return snapshot_type(spine);
+    }
+
+    // Element access
+    const_reference operator[](size_type pos) const {
+        Location at = locate(pos);
+        return spine->chunks[at.chunk]->nodes[at.node]->data()[at.offset];
+    }
+
+    const_reference at(size_type pos) const {
+        if (pos >= size()) throw std::out_of_range("cow_unrolled_list::at");
+        return (*this)[pos];
+    }
+
+    const_reference front() const {
+        return spine->chunks.front()->nodes.front()->data()[0];
+    }
+
+    const_reference back() const {
+        const Node& last = *spine->chunks.back()->nodes.back();
+        return last.data()[last.size - 1];
+    }
+
+    // Replace the element at pos, copying its node first if it is shared
+    template<typename... Args>
+    void assign(size_type pos, Args&&... args) {
+        Location at = locate(pos);
+        Node& node = own_node(own_chunk(own_spine(), at.chunk), at.node);
+        node.data()[at.offset] = T(std::forward<Args>(args)...);
+    }
+
+    // Iterators
+    const_iterator begin() const noexcept { return const_iterator(spine.get()); }
+    const_iterator end() const noexcept { return const_iterator(spine.get(), spine ? spine->chunks.size() : 0); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Size
+    bool empty() const noexcept { return size() == 0; }
+    size_type size() const noexcept { return spine ? spine->size : 0; }
+
+    // Modifiers
+    void clear() noexcept {
+        spine.reset();
+    }
+
+    void push_back(const T& value) { emplace(size(), value); }
+    void push_back(T&& value) { emplace(size(), std::move(value)); }
+    void push_front(const T& value) { emplace(0, value); }
+    void push_front(T&& value) { emplace(0, std::move(value)); }
+    void insert(size_type pos, const T& value) { emplace(pos, value); }
+    void insert(size_type pos, T&& value) { emplace(pos, std::move(value)); }
+
+    void pop_back() { erase(size() - 1); }
+    void pop_front() { erase(0); }
+
+    // Emplace before the element at pos, pos == size() appends
+    template<typename... Args>
+    void emplace(size_type pos, Args&&... args) {
+        Spine& owned = own_spine();
+
+        // Appends go straight to the last node, or to a new node once it is
+        // full, which starts a new chunk once the last chunk is full too
+        if (pos == owned.size) {
+            if (owned.chunks.empty() || (owned.chunks.back()->nodes.size() == ChunkMaxNodes &&
+                                         owned.chunks.back()->nodes.back()->is_full())) {
+                owned.chunks.reserve(owned.chunks.size() + 1);
+                NodePtr node = create_node();
+                node->emplace(0, std::forward<Args>(args)...);
+                ChunkPtr chunk = create_chunk();
+                chunk->nodes.push_back(std::move(node));
+                owned.chunks.push_back(std::move(chunk));
+            } else {
+                Chunk& last = own_chunk(owned, owned.chunks.size() - 1);
+                if (last.nodes.back()->is_full()) {
+                    NodePtr node = create_node();
+                    node->emplace(0, std::forward<Args>(args)...);
+                    last.nodes.push_back(std::move(node));
+                } else {
+                    Node& node = own_node(last, last.nodes.size() - 1);
+                    node.emplace(node.size, std::forward<Args>(args)...);
+                }
+            }
+            ++owned.chunks.back()->size;
+            ++owned.size;
+            return;
+        }
+
+        // An insert at the start of a node goes to the end of the previous one
+        Location at = locate(pos);
+        if (at.offset == 0 && (at.node > 0 || at.chunk > 0)) {
+            if (at.node == 0) {
+                --at.chunk;
+                at.node = owned.chunks[at.chunk]->nodes.size();
+            }
+            --at.node;
+            at.offset = owned.chunks[at.chunk]->nodes[at.node]->size;
+        }
+
+        // Splitting a node adds one to its chunk, so a full chunk is split first
+        if (owned.chunks[at.chunk]->nodes[at.node]->is_full() &&
+            owned.chunks[at.chunk]->nodes.size() == ChunkMaxNodes) {
+            split_chunk(owned, at.chunk);
+            if (at.node >= ChunkMaxNodes / 2) {
+                ++at.chunk;
+                at.node -= ChunkMaxNodes / 2;
+            }
+        }
+
+        Chunk& chunk = own_chunk(owned, at.chunk);
+        if (chunk.nodes[at.node]->is_full()) {
+            // Split into two new nodes, elements are copied if a snapshot still
+            // shares them or their move may throw. The chunk slot is reserved
+            // first, so nothing can throw once elements have been moved out.
+            chunk.nodes.reserve(chunk.nodes.size() + 1);
+            Node& full = *chunk.nodes[at.node];
+            bool unique = is_unique(chunk.nodes[at.node]);
+            size_t half = NodeMaxSize / 2;
+            NodePtr front = create_node();
+            NodePtr back = create_node();
+            for (size_t i = 0; i < full.size; ++i) {
+                Node& target = i < half ? *front : *back;
+                if (unique && std::is_nothrow_move_constructible_v<T>) {
+                    new (target.data() + target.size) T(std::move(full.data()[i]));
+                } else {
+                    new (target.data() + target.size) T(full.data()[i]);
+                }
+                ++target.size;
+            }
+            chunk.nodes[at.node] = std::move(front);
+            chunk.nodes.insert(chunk.nodes.begin() + at.node + 1, std::move(back));
+            if (at.offset > half) {
+                ++at.node;
+                at.offset -= half;
+            }
+        }
+
+        own_node(chunk, at.node).emplace(at.offset, std::forward<Args>(args)...);
+        ++chunk.size;
+        ++owned.size;
+    }
+
+    void erase(size_type pos) {
+        Spine& owned = own_spine();
+        Location at = locate(pos);
+        if (owned.chunks[at.chunk]->size == 1) {
+            owned.chunks.erase(owned.chunks.begin() + at.chunk);
+        } else {
+            Chunk& chunk = own_chunk(owned, at.chunk);
+            if (chunk.nodes[at.node]->size == 1) {
+                chunk.nodes.erase(chunk.nodes.begin() + at.node);
+            } else {
+                own_node(chunk, at.node).erase(at.offset);
+            }
+            --chunk.size;
+        }
+        --owned.size;
+    }
+};
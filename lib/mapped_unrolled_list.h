@@ -0,0 +1,434 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "unrolled_list_locate.h"
+
+// Unrolled list whose nodes live in a memory-mapped file.
+//
+// Nodes are linked by file offsets instead of pointers, so the file can be
+// unmapped and mapped again at any address: reopening a list of any size only
+// maps the file, nothing is deserialized. Space is handed out by a small arena
+// over the mapping that grows the file geometrically, and destroyed nodes go
+// to a free list in the file that create_node draws from first. Changes reach
+// the file through the shared mapping as they are made, flush() waits until
+// they are on disk. Elements must be trivially copyable, the file uses the
+// native byte order and layout and is not safe to share between processes
+// that modify it at the same time.
+template<typename T, size_t NodeMaxSize = 64>
+class mapped_unrolled_list {
+    static_assert(std::is_trivially_copyable_v<T>, "mapped_unrolled_list stores elements as raw bytes");
+
+private:
+    using Offset = uint64_t; // Byte offset in the file, 0 is the null offset
+
+    struct Node {
+        Offset next; // Offset of the next node
+        Offset prev; // Offset of the previous node
+        uint64_t size; // Current number of elements
+        T data[NodeMaxSize]; // Array of elements
+    };
+
+    // Stored at offset 0 of the file
+    struct FileHeader {
+        uint32_t magic; // FileMagic
+        uint16_t version; // FileVersion
+        uint16_t header_size; // sizeof(FileHeader)
+        uint32_t element_size; // sizeof(T)
+        uint32_t node_max_size; // NodeMaxSize
+        uint64_t capacity; // Length of the file
+        uint64_t used; // End of the space handed out so far
+        Offset free_head; // First node of the free list, linked through next
+        Offset head; // First node of the list
+        Offset tail; // Last node of the list
+        uint64_t size; // Total number of elements
+        uint64_t node_count; // Number of nodes in the list
+    };
+
+    static constexpr uint32_t FileMagic = 0x464d4c55; // "ULMF"
+    static constexpr uint16_t FileVersion = 1;
+    static constexpr size_t NodeAlign = alignof(Node) > 64 ? alignof(Node) : 64;
+    static constexpr size_t NodeStride = (sizeof(Node) + NodeAlign - 1) / NodeAlign * NodeAlign;
+    static constexpr size_t FirstNode = (sizeof(FileHeader) + NodeAlign - 1) / NodeAlign * NodeAlign;
+    static constexpr size_t MinCapacity = 1 << 16;
+
+    // File-backed arena: maps the file, grows it and hands out node slots
+    class file_arena {
+    private:
+        int fd;
+        unsigned char* base;
+        size_t mapped;
+
+        void map(size_t length) {
+            void* addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(), "mapped_unrolled_list: mmap");
+            }
+            base = static_cast<unsigned char*>(addr);
+            mapped = length;
+        }
+
+        void unmap() noexcept {
+            if (base) ::munmap(base, mapped);
+            base = nullptr;
+            mapped = 0;
+        }
+
+    public:
+        file_arena() : fd(-1), base(nullptr), mapped(0) {}
+
+        file_arena(const std::string& path, bool truncate) : fd(-1), base(nullptr), mapped(0) {
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "mapped_unrolled_list: open " + path);
+            }
+            try {
+                struct stat info;
+                if (::fstat(fd, &info) != 0) {
+                    throw std::system_error(errno, std::generic_category(), "mapped_unrolled_list: fstat");
+                }
+                if (info.st_size == 0) {
+                    resize(MinCapacity);
+                    FileHeader& header = this->header();
+                    header = FileHeader{FileMagic, FileVersion, uint16_t(sizeof(FileHeader)), uint32_t(sizeof(T)),
+                                        uint32_t(NodeMaxSize), MinCapacity, FirstNode, 0, 0, 0, 0, 0};
+                } else {
+                    if (size_t(info.st_size) < sizeof(FileHeader)) {
+                        throw std::runtime_error("mapped_unrolled_list: file too short");
+                    }
+                    map(size_t(info.st_size));
+                    check(header(), size_t(info.st_size));
+                }
+            } catch (...) {
+                unmap();
+                ::close(fd);
+                throw;
+            }
+        }
+
+        file_arena(file_arena&& other) noexcept
+            : fd(std::exchange(other.fd, -1)), base(std::exchange(other.base, nullptr)),
+              mapped(std::exchange(other.mapped, 0)) {}
+
+        file_arena& operator=(file_arena&& other) noexcept {
+            if (this != &other) {
+                close();
+                fd = std::exchange(other.fd, -1);
+                base = std::exchange(other.base, nullptr);
+                mapped = std::exchange(other.mapped, 0);
+            }
+            return *this;
+        }
+
+        ~file_arena() {
+            close();
+        }
+
+        void close() noexcept {
+            unmap();
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+
+        static void check(const FileHeader& header, size_t length) {
+            if (header.magic != FileMagic || header.version != FileVersion ||
+                header.header_size != sizeof(FileHeader)) {
+                throw std::runtime_error("mapped_unrolled_list: not a mapped_unrolled_list file");
+            }
+            if (header.element_size != sizeof(T) || header.node_max_size != NodeMaxSize) {
+                throw std::runtime_error("mapped_unrolled_list: file was created with a different layout");
+            }
+            if (header.capacity != length || header.used > length) {
+                throw std::runtime_error("mapped_unrolled_list: file is corrupt");
+            }
+        }
+
+        FileHeader& header() const noexcept {
+            return *reinterpret_cast<FileHeader*>(base);
+        }
+
+        Node* node(Offset offset) const noexcept {
+            return offset ? reinterpret_cast<Node*>(base + offset) : nullptr;
+        }
+
+        // Grow the file and the mapping to length bytes. Offsets stay valid,
+        // pointers into the old mapping do not.
+        void resize(size_t length) {
+            if (::ftruncate(fd, off_t(length)) != 0) {
+                throw std::system_error(errno, std::generic_category(), "mapped_unrolled_list: ftruncate");
+            }
+            unmap();
+            map(length);
+        }
+
+        // Slot for one node, from the free list or the end of the used space
+        Offset allocate() {
+            FileHeader* header = &this->header();
+            if (header->free_head) {
+                Offset offset = header->free_head;
+                header->free_head = node(offset)->next;
+                return offset;
+            }
+            if (header->used + NodeStride > header->capacity) {
+                // A node may be larger than the whole file so far
+                size_t length = header->capacity * 2;
+                while (header->used + NodeStride > length) length *= 2;
+                resize(length);
+                header = &this->header();
+                header->capacity = length;
+            }
+            Offset offset = header->used;
+            header->used += NodeStride;
+            return offset;
+        }
+
+        void deallocate(Offset offset) noexcept {
+            node(offset)->next = header().free_head;
+            header().free_head = offset;
+        }
+
+        void sync() const {
+            if (base && ::msync(base, mapped, MS_SYNC) != 0) {
+                throw std::system_error(errno, std::generic_category(), "mapped_unrolled_list: msync");
+            }
+        }
+    };
+
+    file_arena arena;
+
+    FileHeader& header() const noexcept {
+        return arena.header();
+    }
+
+    Node* node_at(Offset offset) const noexcept {
+        return arena.node(offset);
+    }
+
+    // Allocate an empty node and link it between prev and next, may remap
+    Offset create_node(Offset prev, Offset next) {
+        Offset offset = arena.allocate();
+        Node* node = node_at(offset);
+        node->next = next;
+        node->prev = prev;
+        node->size = 0;
+        if (prev) node_at(prev)->next = offset; else header().head = offset;
+        if (next) node_at(next)->prev = offset; else header().tail = offset;
+        ++header().node_count;
+        return offset;
+    }
+
+    // Unlink the node and return its slot to the free list
+    void destroy_node(Offset offset) noexcept {
+        Node* node = node_at(offset);
+        if (node->prev) node_at(node->prev)->next = node->next; else header().head = node->next;
+        if (node->next) node_at(node->next)->prev = node->prev; else header().tail = node->prev;
+        --header().node_count;
+        arena.deallocate(offset);
+    }
+
+    // File offset of the node holding the element at index and the position in
+    // it, index == size maps past the tail
+    std::pair<Offset, size_t> locate(size_t index) const {
+        const FileHeader& shared = header();
+        return unrolled_list_locate(shared.head, shared.tail, size_t(shared.size), index,
+            [this](Offset offset) { return size_t(node_at(offset)->size); },
+            [this](Offset offset) { return node_at(offset)->next; });
+    }
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    // Forward iterator holding offsets, so it survives remapping but not
+    // structural changes to the node it points into
+    class const_iterator {
+    private:
+        const mapped_unrolled_list* list;
+        Offset current_node; // Offset of the current node, 0 at the end
+        size_t current_pos; // Current position in node's element array
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator(const mapped_unrolled_list* list = nullptr, Offset node = 0, size_t pos = 0)
+            : list(list), current_node(node), current_pos(pos) {}
+
+        reference operator*() const {
+            return list->node_at(current_node)->data[current_pos];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        const_iterator& operator++() {
+            const Node* node = list->node_at(current_node);
+            if (++current_pos == node->size) {
+                current_node = node->next;
+                current_pos = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return current_node == other.current_node && current_pos == other.current_pos;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Opens the list stored at path, creating an empty one if the file is
+    // missing or empty. Throws if the file holds a list of another layout.
+    explicit mapped_unrolled_list(const std::string& path) : arena(path, false) {}
+
+    // Creates an empty list at path, discarding what the file held
+    static mapped_unrolled_list create(const std::string& path) {
+        return mapped_unrolled_list(file_arena(path, true));
+    }
+
+    mapped_unrolled_list(const mapped_unrolled_list&) = delete;
+    mapped_unrolled_list& operator=(const mapped_unrolled_list&) = delete;
+    mapped_unrolled_list(mapped_unrolled_list&&) noexcept = default;
+    mapped_unrolled_list& operator=(mapped_unrolled_list&&) noexcept = default;
+
+    // Unmaps without syncing, the kernel writes dirty pages back on its own
+    ~mapped_unrolled_list() = default;
+
+    // Blocks until every change so far is written to the file
+    void flush() const {
+        arena.sync();
+    }
+
+    // Element access. References are invalidated by any insertion, which
+    // may grow and remap the file.
+    reference operator[](size_type pos) {
+        auto [node, offset] = locate(pos);
+        return node_at(node)->data[offset];
+    }
+
+    const_reference operator[](size_type pos) const {
+        auto [node, offset] = locate(pos);
+        return node_at(node)->data[offset];
+    }
+
+    reference at(size_type pos) {
+        if (pos >= size()) throw std::out_of_range("mapped_unrolled_list::at");
+        return (*this)[pos];
+    }
+
+    const_reference at(size_type pos) const {
+        if (pos >= size()) throw std::out_of_range("mapped_unrolled_list::at");
+        return (*this)[pos];
+    }
+
+    reference front() { return node_at(header().head)->data[0]; }
+    const_reference front() const { return node_at(header().head)->data[0]; }
+
+    reference back() {
+        Node* last = node_at(header().tail);
+        return last->data[last->size - 1];
+    }
+
+    const_reference back() const {
+        const Node* last = node_at(header().tail);
+        return last->data[last->size - 1];
+    }
+
+    // Iterators
+    const_iterator begin() const noexcept { return const_iterator(this, header().head, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, 0, 0); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Size
+    bool empty() const noexcept { return header().size == 0; }
+    size_type size() const noexcept { return header().size; }
+    size_type node_count() const noexcept { return header().node_count; }
+
+    // Length of the backing file in bytes, including free node slots
+    size_type file_size() const noexcept { return header().capacity; }
+
+    // Modifiers
+    // Returns every node to the free list, the file does not shrink
+    void clear() noexcept {
+        while (header().tail) destroy_node(header().tail);
+        header().size = 0;
+    }
+
+    void push_back(const T& value) { insert(size(), value); }
+    void push_front(const T& value) { insert(0, value); }
+
+    void pop_back() { erase(size() - 1); }
+    void pop_front() { erase(0); }
+
+    // Insert before the element at pos, pos == size() appends
+    void insert(size_type pos, const T& value) {
+        T copy = value; // value may live in the mapping, which may move
+        auto [offset, index] = locate(pos);
+        if (!offset || (pos == size() && node_at(offset)->size == NodeMaxSize)) {
+            // A full tail is not split for an append, so the file fills up
+            // with full nodes instead of half-full ones
+            offset = create_node(header().tail, 0);
+            index = 0;
+        } else if (node_at(offset)->size == NodeMaxSize) {
+            // Copy the upper half of the full node into a new one after it.
+            // Creating it may remap the file, so node addresses come after.
+            size_t half = NodeMaxSize / 2;
+            Offset back = create_node(offset, node_at(offset)->next);
+            Node* full = node_at(offset);
+            Node* next = node_at(back);
+            std::memcpy(next->data, full->data + half, (full->size - half) * sizeof(T));
+            next->size = full->size - half;
+            full->size = half;
+            if (index > half) {
+                offset = back;
+                index -= half;
+            }
+        }
+
+        Node* node = node_at(offset);
+        std::memmove(node->data + index + 1, node->data + index, (node->size - index) * sizeof(T));
+        node->data[index] = copy;
+        ++node->size;
+        ++header().size;
+    }
+
+    void erase(size_type pos) {
+        auto [offset, index] = locate(pos);
+        Node* node = node_at(offset);
+        std::memmove(node->data + index, node->data + index + 1, (node->size - index - 1) * sizeof(T));
+        if (--node->size == 0) destroy_node(offset);
+        --header().size;
+    }
+
+private:
+    explicit mapped_unrolled_list(file_arena&& arena) : arena(std::move(arena)) {}
+};
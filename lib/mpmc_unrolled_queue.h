@@ -0,0 +1,364 @@
+#pragma once
+
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Lock-free multi-producer/multi-consumer queue built on a chain of unrolled
+// nodes.
+//
+// Producers claim slots in the tail node with a fetch-add on its enqueue
+// index, consumers claim slots in the head node with a fetch-add on its
+// dequeue index. Every slot carries a state byte: a producer publishes its
+// element by moving the slot from Empty to Full, a consumer takes it by
+// exchanging the state with Taken. A consumer that overtakes a slow producer
+// leaves the slot Taken and the producer retries with a fresh slot.
+//
+// Drained nodes are retired through a small epoch-based reclaimer and freed
+// once no thread can still hold a pointer to them. push_n/pop_n claim a whole
+// run of slots with a single fetch-add. Elements of one producer are dequeued
+// in the order they were pushed, also within a push_n batch.
+template<typename T, size_t NodeMaxSize = 128, typename Allocator = std::allocator<T>>
+class mpmc_unrolled_queue {
+private:
+    static constexpr size_t CacheLine = 64;
+
+    enum SlotState : uint8_t { Empty, Full, Taken };
+
+    struct Node {
+        alignas(CacheLine) std::atomic<size_t> enqueue_index; // Next slot for producers
+        alignas(CacheLine) std::atomic<size_t> dequeue_index; // Next slot for consumers
+        alignas(CacheLine) std::atomic<Node*> next; // Pointer to the next node
+        std::array<std::atomic<uint8_t>, NodeMaxSize> state; // SlotState of every slot
+        alignas(T) unsigned char storage[NodeMaxSize * sizeof(T)]; // Array of elements
+
+        Node() : enqueue_index(0), dequeue_index(0), next(nullptr) {
+            for (auto& slot : state) slot.store(Empty, std::memory_order_relaxed);
+        }
+
+        T* data() { return reinterpret_cast<T*>(storage); }
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
+    // Epoch-based reclamation. A thread pins the current epoch in one of a
+    // fixed set of slots for the duration of an operation. The global epoch
+    // only advances once every pinned slot has caught up with it, so a node
+    // retired in epoch e can be freed once the global epoch reaches e + 2.
+    class epoch_reclaimer {
+    private:
+        static constexpr size_t Pins = 64;
+        static constexpr size_t RetireBatch = 8;
+
+        struct alignas(CacheLine) Pin {
+            std::atomic<uint64_t> value{0}; // Pinned epoch << 1 | 1, or 0 when idle
+        };
+
+    public:
+        explicit epoch_reclaimer(mpmc_unrolled_queue& queue) : queue(queue), global_epoch(1) {}
+
+        ~epoch_reclaimer() {
+            for (auto& entry : retired) queue.destroy_node(entry.second);
+        }
+
+        class guard {
+        public:
+            explicit guard(epoch_reclaimer& reclaimer) {
+                thread_local const size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+                for (size_t i = hint;; ++i) {
+                    Pin& pin = reclaimer.pins[i % Pins];
+                    uint64_t expected = 0;
+                    uint64_t pinned = reclaimer.global_epoch.load(std::memory_order_seq_cst) << 1 | 1;
+                    if (pin.value.compare_exchange_strong(expected, pinned, std::memory_order_seq_cst)) {
+                        slot = &pin;
+                        break;
+                    }
+                    if (i - hint + 1 == Pins) std::this_thread::yield(); // More threads than pins
+                }
+            }
+
+            ~guard() {
+                slot->value.store(0, std::memory_order_release);
+            }
+
+            guard(const guard&) = delete;
+            guard& operator=(const guard&) = delete;
+
+        private:
+            Pin* slot = nullptr;
+        };
+
+        void retire(Node* node) {
+            std::lock_guard<std::mutex> lock(retired_mutex);
+            retired.emplace_back(global_epoch.load(std::memory_order_seq_cst), node);
+            if (retired.size() < RetireBatch) return;
+
+            try_advance();
+            uint64_t epoch = global_epoch.load(std::memory_order_seq_cst);
+            auto freed = std::partition(retired.begin(), retired.end(),
+                                        [epoch](const auto& entry) { return entry.first + 2 > epoch; });
+            for (auto it = freed; it != retired.end(); ++it) queue.destroy_node(it->second);
+            retired.erase(freed, retired.end());
+        }
+
+    private:
+        void try_advance() {
+            uint64_t epoch = global_epoch.load(std::memory_order_seq_cst);
+            for (const Pin& pin : pins) {
+                uint64_t value = pin.value.load(std::memory_order_seq_cst);
+                if ((value & 1) && (value >> 1) != epoch) return;
+            }
+            global_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+        }
+
+        mpmc_unrolled_queue& queue;
+        std::atomic<uint64_t> global_epoch;
+        std::array<Pin, Pins> pins;
+        std::mutex retired_mutex; // Retiring happens once per node, not per element
+        std::vector<std::pair<uint64_t, Node*>> retired;
+    };
+
+    alignas(CacheLine) std::atomic<Node*> head;
+    alignas(CacheLine) std::atomic<Node*> tail;
+    NodeAllocator node_allocator;
+    epoch_reclaimer reclaimer;
+
+    Node* create_node() {
+        Node* node = NodeAllocatorTraits::allocate(node_allocator, 1);
+        try {
+            NodeAllocatorTraits::construct(node_allocator, node);
+        } catch (...) {
+            NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroy_node(Node* node) noexcept {
+        NodeAllocatorTraits::destroy(node_allocator, node);
+        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+    }
+
+    // Publish a slot the caller has already constructed. On failure a consumer
+    // gave up on the slot and the value is moved back into value.
+    static bool publish(Node* node, size_t index, T& value) {
+        uint8_t expected = Empty;
+        if (node->state[index].compare_exchange_strong(expected, Full, std::memory_order_release,
+                                                       std::memory_order_relaxed)) {
+            return true;
+        }
+        T* slot = node->data() + index;
+        value = std::move(*slot);
+        slot->~T();
+        return false;
+    }
+
+    // Append a new node holding the first count values of values after the
+    // full node last. Returns false if another producer appended first, in
+    // which case nothing was consumed from values.
+    bool append_node(Node* last, T* values, size_t count) {
+        Node* node = create_node();
+        for (size_t i = 0; i < count; ++i) {
+            new (node->data() + i) T(std::move(values[i]));
+            node->state[i].store(Full, std::memory_order_relaxed);
+        }
+        node->enqueue_index.store(count, std::memory_order_relaxed);
+
+        Node* expected = nullptr;
+        if (last->next.compare_exchange_strong(expected, node, std::memory_order_release,
+                                               std::memory_order_acquire)) {
+            tail.compare_exchange_strong(last, node, std::memory_order_release);
+            return true;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = std::move(node->data()[i]);
+            node->data()[i].~T();
+        }
+        destroy_node(node);
+        tail.compare_exchange_strong(last, expected, std::memory_order_release);
+        return false;
+    }
+
+    // Push values[0, count) in order, moving the elements out. Must run under a guard.
+    void push_block(T* values, size_t count) {
+        while (count > 0) {
+            Node* last = tail.load(std::memory_order_acquire);
+            size_t index = last->enqueue_index.fetch_add(count, std::memory_order_acq_rel);
+
+            if (index >= NodeMaxSize) {
+                Node* next = last->next.load(std::memory_order_acquire);
+                if (next) {
+                    tail.compare_exchange_strong(last, next, std::memory_order_release);
+                } else {
+                    size_t batch = std::min(count, NodeMaxSize);
+                    if (append_node(last, values, batch)) {
+                        values += batch;
+                        count -= batch;
+                    }
+                }
+                continue;
+            }
+
+            // Fill the claimed run in order. Once a consumer has given up on a
+            // slot, the rest of the run is abandoned and the remaining values
+            // are retried in a later run, so they stay behind the ones already
+            // published and a producer's elements keep their order.
+            size_t claimed = std::min(count, NodeMaxSize - index);
+            size_t published = 0;
+            for (; published < claimed; ++published) {
+                new (last->data() + index + published) T(std::move(values[published]));
+                if (!publish(last, index + published, values[published])) break;
+            }
+            for (size_t i = published + 1; i < claimed; ++i) {
+                last->state[index + i].store(Taken, std::memory_order_relaxed);
+            }
+            values += published;
+            count -= published;
+        }
+    }
+
+    // Take the element in a claimed slot, if its producer got there first
+    static bool take(Node* node, size_t index, std::optional<T>& out) {
+        if (node->state[index].exchange(Taken, std::memory_order_acquire) != Full) return false;
+        T* slot = node->data() + index;
+        out.emplace(std::move(*slot));
+        slot->~T();
+        return true;
+    }
+
+    // Step head past a drained node. Returns false if there is no next node.
+    bool advance_head(Node* first) {
+        Node* next = first->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        Node* last = first;
+        tail.compare_exchange_strong(last, next, std::memory_order_release); // Never leave tail behind head
+        if (head.compare_exchange_strong(first, next, std::memory_order_acq_rel)) {
+            reclaimer.retire(first);
+        }
+        return true;
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+
+    explicit mpmc_unrolled_queue(const Allocator& alloc = Allocator())
+        : node_allocator(alloc), reclaimer(*this) {
+        Node* node = create_node();
+        head.store(node, std::memory_order_relaxed);
+        tail.store(node, std::memory_order_relaxed);
+    }
+
+    mpmc_unrolled_queue(const mpmc_unrolled_queue&) = delete;
+    mpmc_unrolled_queue& operator=(const mpmc_unrolled_queue&) = delete;
+
+    // Not thread-safe, all producers and consumers must be finished
+    ~mpmc_unrolled_queue() {
+        Node* node = head.load(std::memory_order_relaxed);
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < NodeMaxSize; ++i) {
+                if (node->state[i].load(std::memory_order_relaxed) == Full) node->data()[i].~T();
+            }
+            destroy_node(node);
+            node = next;
+        }
+    }
+
+    // Producers
+    void push(const T& value) {
+        T copy(value);
+        push(std::move(copy));
+    }
+
+    void push(T&& value) {
+        typename epoch_reclaimer::guard guard(reclaimer);
+        push_block(&value, 1);
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        push(T(std::forward<Args>(args)...));
+    }
+
+    // Push count elements starting at first, claiming slots a block at a time
+    template<typename InputIt>
+    void push_n(InputIt first, size_t count) {
+        std::vector<T> values;
+        values.reserve(count);
+        for (size_t i = 0; i < count; ++i, ++first) values.push_back(*first);
+
+        typename epoch_reclaimer::guard guard(reclaimer);
+        push_block(values.data(), values.size());
+    }
+
+    // Consumers
+    std::optional<T> try_pop() {
+        typename epoch_reclaimer::guard guard(reclaimer);
+        std::optional<T> result;
+        while (true) {
+            Node* first = head.load(std::memory_order_acquire);
+            size_t index = first->dequeue_index.load(std::memory_order_acquire);
+            if (index >= first->enqueue_index.load(std::memory_order_acquire) && index < NodeMaxSize) {
+                return std::nullopt;
+            }
+            if (index < NodeMaxSize) {
+                index = first->dequeue_index.fetch_add(1, std::memory_order_acq_rel);
+                if (index < NodeMaxSize) {
+                    if (take(first, index, result)) return result;
+                    continue;
+                }
+            }
+            if (!advance_head(first)) return std::nullopt;
+        }
+    }
+
+    bool try_pop(T& out) {
+        auto value = try_pop();
+        if (!value) return false;
+        out = std::move(*value);
+        return true;
+    }
+
+    // Pop up to max_count elements into out with one claim per node.
+    // Returns the number of elements written.
+    template<typename OutputIt>
+    size_t pop_n(OutputIt out, size_t max_count) {
+        typename epoch_reclaimer::guard guard(reclaimer);
+        size_t popped = 0;
+        std::optional<T> value;
+        while (popped < max_count) {
+            Node* first = head.load(std::memory_order_acquire);
+            size_t index = first->dequeue_index.load(std::memory_order_acquire);
+            size_t published = std::min(first->enqueue_index.load(std::memory_order_acquire), NodeMaxSize);
+            if (index >= published && index < NodeMaxSize) break;
+
+            if (index < NodeMaxSize) {
+                size_t want = std::min(max_count - popped, published - index);
+                index = first->dequeue_index.fetch_add(want, std::memory_order_acq_rel);
+                size_t end = std::min(index + want, NodeMaxSize);
+                for (; index < end; ++index) {
+                    if (take(first, index, value)) {
+                        *out = std::move(*value);
+                        ++out;
+                        ++popped;
+                    }
+                }
+                continue;
+            }
+            if (!advance_head(first)) break;
+        }
+        return popped;
+    }
+};
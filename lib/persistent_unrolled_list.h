@@ -0,0 +1,417 @@
+#pragma once
+
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Persistent (immutable) unrolled list for keeping many versions of a sequence.
+//
+// Elements live in immutable leaf blocks of up to NodeMaxSize elements. The
+// leaves hang off a tree of index nodes with up to Branching children each,
+// and every index node records the number of elements below it. push_back,
+// insert, erase and set return a new version that copies one leaf plus the
+// index nodes on the path from the root. A split copies two leaves, and an
+// erase that leaves a node less than half full merges it with a neighbour or
+// evens the two out, so the height follows the current size. Every other node
+// is shared with the old version. Nodes are reference counted and freed with
+// the last version that uses them.
+template<typename T, size_t NodeMaxSize = 10, size_t Branching = 16, typename Allocator = std::allocator<T>>
+class persistent_unrolled_list {
+private:
+    static_assert(NodeMaxSize >= 2 && Branching >= 2);
+
+    struct Node {
+        size_t size = 0; // Number of elements below this node
+    };
+
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Leaf : Node {
+        alignas(T) unsigned char storage[NodeMaxSize * sizeof(T)]; // Array of elements
+
+        ~Leaf() {
+            for (size_t i = 0; i < this->size; ++i) {
+                data()[i].~T();
+            }
+        }
+
+        T* data() { return reinterpret_cast<T*>(storage); }
+        const T* data() const { return reinterpret_cast<const T*>(storage); }
+
+        void push_back(const T& value) {
+            new (data() + this->size) T(value);
+            ++this->size;
+        }
+    };
+
+    struct Inner : Node {
+        size_t count = 0; // Number of children
+        std::array<NodePtr, Branching> children;
+    };
+
+    using LeafAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Leaf>;
+    using InnerAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Inner>;
+
+    // A rebuilt node, plus the second half if it had to split
+    struct Rebuilt {
+        NodePtr node;
+        NodePtr split;
+    };
+
+    NodePtr root; // nullptr for the empty list
+    size_t height = 0; // Number of index levels above the leaves
+    Allocator allocator;
+
+    persistent_unrolled_list(NodePtr root, size_t height, const Allocator& alloc)
+        : root(std::move(root)), height(height), allocator(alloc) {}
+
+    static const Leaf& as_leaf(const NodePtr& node) { return static_cast<const Leaf&>(*node); }
+    static const Inner& as_inner(const NodePtr& node) { return static_cast<const Inner&>(*node); }
+
+    std::shared_ptr<Leaf> make_leaf() const {
+        return std::allocate_shared<Leaf>(LeafAllocator(allocator));
+    }
+
+    // Leaf holding element(first) .. element(last - 1)
+    template<typename Element>
+    std::shared_ptr<Leaf> make_leaf(Element element, size_t first, size_t last) const {
+        auto leaf = make_leaf();
+        for (size_t i = first; i < last; ++i) {
+            leaf->push_back(element(i));
+        }
+        return leaf;
+    }
+
+    std::shared_ptr<Inner> make_inner(const NodePtr* children, size_t count) const {
+        auto inner = std::allocate_shared<Inner>(InnerAllocator(allocator));
+        for (size_t i = 0; i < count; ++i) {
+            inner->children[i] = children[i];
+            inner->size += children[i]->size;
+        }
+        inner->count = count;
+        return inner;
+    }
+
+    // Rebuild an index node with children[index] replaced by the rebuilt child
+    Rebuilt replace_child(const Inner& inner, size_t index, const Rebuilt& child) const {
+        std::array<NodePtr, Branching + 1> children;
+        size_t count = 0;
+        for (size_t i = 0; i < inner.count; ++i) {
+            if (i != index) {
+                children[count++] = inner.children[i];
+                continue;
+            }
+            if (child.node) children[count++] = child.node;
+            if (child.split) children[count++] = child.split;
+        }
+
+        if (count == 0) return {};
+        if (count <= Branching) return {make_inner(children.data(), count), nullptr};
+        size_t half = count / 2;
+        return {make_inner(children.data(), half), make_inner(children.data() + half, count - half)};
+    }
+
+    Rebuilt insert_at(const NodePtr& node, size_t level, size_t pos, const T& value) const {
+        if (level == 0) {
+            const Leaf& leaf = as_leaf(node);
+            auto element = [&](size_t i) -> const T& {
+                return i < pos ? leaf.data()[i] : i == pos ? value : leaf.data()[i - 1];
+            };
+            size_t total = leaf.size + 1;
+            if (total <= NodeMaxSize) return {make_leaf(element, 0, total), nullptr};
+            return {make_leaf(element, 0, total / 2), make_leaf(element, total / 2, total)};
+        }
+
+        const Inner& inner = as_inner(node);
+        size_t index = 0;
+        for (; index + 1 < inner.count && pos > inner.children[index]->size; ++index) {
+            pos -= inner.children[index]->size;
+        }
+        return replace_child(inner, index, insert_at(inner.children[index], level - 1, pos, value));
+    }
+
+    Rebuilt erase_at(const NodePtr& node, size_t level, size_t pos) const {
+        if (level == 0) {
+            const Leaf& leaf = as_leaf(node);
+            if (leaf.size == 1) return {};
+            auto element = [&](size_t i) -> const T& { return leaf.data()[i < pos ? i : i + 1]; };
+            return {make_leaf(element, 0, leaf.size - 1), nullptr};
+        }
+
+        const Inner& inner = as_inner(node);
+        size_t index = 0;
+        for (; pos >= inner.children[index]->size; ++index) {
+            pos -= inner.children[index]->size;
+        }
+        Rebuilt child = erase_at(inner.children[index], level - 1, pos);
+        if (!child.node) return replace_child(inner, index, child);
+        return rebalance_child(inner, index, level, child.node);
+    }
+
+    // Rebuild an index node at level with children[index] replaced by child.
+    // A child less than half full is merged with a neighbour if both fit into
+    // one node, or else the two share their elements or children evenly.
+    Rebuilt rebalance_child(const Inner& inner, size_t index, size_t level, const NodePtr& child) const {
+        bool underfull = level == 1 ? child->size < NodeMaxSize / 2 : as_inner(child).count < Branching / 2;
+        if (!underfull || inner.count == 1) return replace_child(inner, index, {child, nullptr});
+
+        size_t first = index + 1 < inner.count ? index : index - 1; // Left node of the pair
+        const NodePtr& left = first == index ? child : inner.children[first];
+        const NodePtr& right = first == index ? inner.children[index + 1] : child;
+        Rebuilt pair;
+        if (level == 1) {
+            const Leaf& l = as_leaf(left);
+            const Leaf& r = as_leaf(right);
+            auto element = [&](size_t i) -> const T& {
+                return i < l.size ? l.data()[i] : r.data()[i - l.size];
+            };
+            size_t total = l.size + r.size;
+            if (total <= NodeMaxSize) {
+                pair = {make_leaf(element, 0, total), nullptr};
+            } else {
+                pair = {make_leaf(element, 0, total / 2), make_leaf(element, total / 2, total)};
+            }
+        } else {
+            const Inner& l = as_inner(left);
+            const Inner& r = as_inner(right);
+            std::array<NodePtr, 2 * Branching> children;
+            std::copy_n(l.children.begin(), l.count, children.begin());
+            std::copy_n(r.children.begin(), r.count, children.begin() + l.count);
+            size_t total = l.count + r.count;
+            if (total <= Branching) {
+                pair = {make_inner(children.data(), total), nullptr};
+            } else {
+                pair = {make_inner(children.data(), total / 2),
+                        make_inner(children.data() + total / 2, total - total / 2)};
+            }
+        }
+
+        std::array<NodePtr, Branching> children;
+        size_t count = 0;
+        for (size_t i = 0; i < inner.count; ++i) {
+            if (i == first) {
+                children[count++] = pair.node;
+                if (pair.split) children[count++] = pair.split;
+            } else if (i != first + 1) {
+                children[count++] = inner.children[i];
+            }
+        }
+        return {make_inner(children.data(), count), nullptr};
+    }
+
+    NodePtr set_at(const NodePtr& node, size_t level, size_t pos, const T& value) const {
+        if (level == 0) {
+            const Leaf& leaf = as_leaf(node);
+            auto element = [&](size_t i) -> const T& { return i == pos ? value : leaf.data()[i]; };
+            return make_leaf(element, 0, leaf.size);
+        }
+
+        const Inner& inner = as_inner(node);
+        size_t index = 0;
+        for (; pos >= inner.children[index]->size; ++index) {
+            pos -= inner.children[index]->size;
+        }
+        Rebuilt child{set_at(inner.children[index], level - 1, pos, value), nullptr};
+        return replace_child(inner, index, child).node;
+    }
+
+    // New version from a rebuilt root, growing or shrinking the tree as needed
+    persistent_unrolled_list with_root(const Rebuilt& rebuilt) const {
+        if (rebuilt.split) {
+            NodePtr children[] = {rebuilt.node, rebuilt.split};
+            return persistent_unrolled_list(make_inner(children, 2), height + 1, allocator);
+        }
+        NodePtr node = rebuilt.node;
+        size_t levels = node ? height : 0;
+        while (levels > 0 && as_inner(node).count == 1) {
+            node = as_inner(node).children[0];
+            --levels;
+        }
+        return persistent_unrolled_list(std::move(node), levels, allocator);
+    }
+
+public:
+    // Forward iterator, valid as long as the version it came from
+    class const_iterator {
+    private:
+        std::vector<std::pair<const Inner*, size_t>> path; // Index nodes above leaf and child taken
+        const Leaf* leaf; // Current leaf, nullptr at the end
+        size_t current_pos; // Current position in leaf's element array
+
+        // Walk down the first children of node to its first leaf
+        void descend(const Node* node, size_t levels) {
+            for (; levels > 0; --levels) {
+                const Inner* inner = static_cast<const Inner*>(node);
+                path.emplace_back(inner, 0);
+                node = inner->children[0].get();
+            }
+            leaf = static_cast<const Leaf*>(node);
+            current_pos = 0;
+        }
+
+        friend class persistent_unrolled_list;
+
+        const_iterator(const Node* root, size_t height) : leaf(nullptr), current_pos(0) {
+            if (root) descend(root, height);
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() : leaf(nullptr), current_pos(0) {}
+
+        reference operator*() const {
+            return leaf->data()[current_pos];
+        }
+
+        pointer operator->() const {
+            return leaf->data() + current_pos;
+        }
+
+        const_iterator& operator++() {
+            if (++current_pos < leaf->size) return *this;
+
+            size_t levels = 0;
+            while (!path.empty()) {
+                auto& [inner, index] = path.back();
+                if (++index < inner->count) {
+                    descend(inner->children[index].get(), levels);
+                    return *this;
+                }
+                path.pop_back();
+                ++levels;
+            }
+            leaf = nullptr;
+            current_pos = 0;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return leaf == other.leaf && current_pos == other.current_pos;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using const_reference = const T&;
+    using iterator = const_iterator;
+
+    persistent_unrolled_list() = default;
+
+    explicit persistent_unrolled_list(const Allocator& alloc) : allocator(alloc) {}
+
+    persistent_unrolled_list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+        : allocator(alloc) {
+        for (const auto& item : init) *this = push_back(item);
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator;
+    }
+
+    // Element access
+    // Descends through raw pointers, the version keeps every node alive and a
+    // read does not need to touch the reference counts
+    const_reference operator[](size_type pos) const {
+        const Node* node = root.get();
+        for (size_t level = height; level > 0; --level) {
+            const Inner& inner = *static_cast<const Inner*>(node);
+            size_t index = 0;
+            for (; pos >= inner.children[index]->size; ++index) {
+                pos -= inner.children[index]->size;
+            }
+            node = inner.children[index].get();
+        }
+        return static_cast<const Leaf*>(node)->data()[pos];
+    }
+
+    const_reference at(size_type pos) const {
+        if (pos >= size()) throw std::out_of_range("persistent_unrolled_list::at");
+        return (*this)[pos];
+    }
+
+    const_reference front() const {
+        return (*this)[0];
+    }
+
+    const_reference back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Iterators
+    const_iterator begin() const { return const_iterator(root.get(), height); }
+    const_iterator end() const { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // Size
+    bool empty() const noexcept { return !root; }
+    size_type size() const noexcept { return root ? root->size : 0; }
+
+    // Versions with one modification applied, this version is left untouched
+    [[nodiscard]] persistent_unrolled_list insert(size_type pos, const T& value) const {
+        if (!root) {
+            auto leaf = make_leaf();
+            leaf->push_back(value);
+            return persistent_unrolled_list(std::move(leaf), 0, allocator);
+        }
+        return with_root(insert_at(root, height, pos, value));
+    }
+
+    [[nodiscard]] persistent_unrolled_list push_back(const T& value) const {
+        return insert(size(), value);
+    }
+
+    [[nodiscard]] persistent_unrolled_list push_front(const T& value) const {
+        return insert(0, value);
+    }
+
+    [[nodiscard]] persistent_unrolled_list erase(size_type pos) const {
+        return with_root(erase_at(root, height, pos));
+    }
+
+    [[nodiscard]] persistent_unrolled_list pop_back() const {
+        return erase(size() - 1);
+    }
+
+    [[nodiscard]] persistent_unrolled_list pop_front() const {
+        return erase(0);
+    }
+
+    [[nodiscard]] persistent_unrolled_list set(size_type pos, const T& value) const {
+        return persistent_unrolled_list(set_at(root, height, pos, value), height, allocator);
+    }
+};
+
+template<typename T, size_t N, size_t B, typename A>
+bool operator==(const persistent_unrolled_list<T, N, B, A>& lhs, const persistent_unrolled_list<T, N, B, A>& rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<typename T, size_t N, size_t B, typename A>
+bool operator!=(const persistent_unrolled_list<T, N, B, A>& lhs, const persistent_unrolled_list<T, N, B, A>& rhs) {
+    return !(lhs == rhs);
+}
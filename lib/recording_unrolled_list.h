@@ -0,0 +1,278 @@
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#include "unrolled_list.h"
+
+// Operations stored in a workload trace
+enum class unrolled_list_trace_op : uint8_t {
+    push_back, push_front, pop_back, pop_front,
+    insert, // position
+    erase, // position
+    access, // position, a read of one element
+    iterate, // position and count, a read of count elements starting at position
+    clear
+};
+
+struct unrolled_list_trace_record {
+    unrolled_list_trace_op op;
+    uint64_t position = 0;
+    uint64_t count = 0;
+};
+
+// Trace layout: a 16-byte header followed by records of one opcode byte and,
+// for positional operations, LEB128 varints of the position and count. Element
+// values are not stored, a replay only needs the element size.
+struct unrolled_list_trace_header {
+    char magic[4] = {'U', 'L', 'T', 'R'};
+    uint32_t version = 1;
+    uint32_t element_size = 0;
+    uint32_t node_max_size = 0; // Of the recorded list
+};
+
+// Buffers records and writes them to out in blocks
+class unrolled_list_trace_writer {
+private:
+    static constexpr size_t BufferSize = 64 * 1024;
+
+    std::ostream* out;
+    unsigned char buffer[BufferSize];
+    size_t used = 0;
+    uint64_t records = 0;
+
+    void put_varint(uint64_t value) noexcept {
+        while (value >= 0x80) {
+            buffer[used++] = uint8_t(value) | 0x80;
+            value >>= 7;
+        }
+        buffer[used++] = uint8_t(value);
+    }
+
+public:
+    unrolled_list_trace_writer(std::ostream& out, size_t element_size, size_t node_max_size) : out(&out) {
+        unrolled_list_trace_header header;
+        header.element_size = uint32_t(element_size);
+        header.node_max_size = uint32_t(node_max_size);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    ~unrolled_list_trace_writer() {
+        flush();
+    }
+
+    unrolled_list_trace_writer(const unrolled_list_trace_writer&) = delete;
+    unrolled_list_trace_writer& operator=(const unrolled_list_trace_writer&) = delete;
+
+    void record(unrolled_list_trace_op op, uint64_t position = 0, uint64_t count = 0) {
+        if (used + 1 + 2 * 10 > BufferSize) flush(); // Opcode and two maximal varints
+        buffer[used++] = uint8_t(op);
+        if (op == unrolled_list_trace_op::insert || op == unrolled_list_trace_op::erase
+                || op == unrolled_list_trace_op::access || op == unrolled_list_trace_op::iterate) {
+            put_varint(position);
+        }
+        if (op == unrolled_list_trace_op::iterate) put_varint(count);
+        ++records;
+    }
+
+    void flush() {
+        out->write(reinterpret_cast<const char*>(buffer), std::streamsize(used));
+        out->flush();
+        used = 0;
+    }
+
+    uint64_t record_count() const noexcept {
+        return records;
+    }
+};
+
+// Reads a trace written by unrolled_list_trace_writer
+class unrolled_list_trace_reader {
+private:
+    std::istream* in;
+    unrolled_list_trace_header header_;
+
+    uint64_t get_varint() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            int byte = in->get();
+            if (byte == std::istream::traits_type::eof()) {
+                throw std::runtime_error("unrolled_list_trace: input ends inside a record");
+            }
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("unrolled_list_trace: malformed varint");
+    }
+
+public:
+    explicit unrolled_list_trace_reader(std::istream& in) : in(&in) {
+        in.read(reinterpret_cast<char*>(&header_), sizeof(header_));
+        if (!in || std::memcmp(header_.magic, "ULTR", 4) != 0) {
+            throw std::runtime_error("unrolled_list_trace: not a trace");
+        }
+        if (header_.version != 1) throw std::runtime_error("unrolled_list_trace: unsupported version");
+    }
+
+    const unrolled_list_trace_header& header() const noexcept {
+        return header_;
+    }
+
+    // Reads the next record, false at the end of the trace
+    bool next(unrolled_list_trace_record& record) {
+        int byte = in->get();
+        if (byte == std::istream::traits_type::eof()) {
+            if (in->bad()) throw std::runtime_error("unrolled_list_trace: read failed");
+            return false;
+        }
+        if (byte > int(unrolled_list_trace_op::clear)) throw std::runtime_error("unrolled_list_trace: unknown operation");
+        record.op = unrolled_list_trace_op(byte);
+        record.position = 0;
+        record.count = 0;
+        if (record.op == unrolled_list_trace_op::insert || record.op == unrolled_list_trace_op::erase
+                || record.op == unrolled_list_trace_op::access || record.op == unrolled_list_trace_op::iterate) {
+            record.position = get_varint();
+        }
+        if (record.op == unrolled_list_trace_op::iterate) record.count = get_varint();
+        return true;
+    }
+};
+
+// unrolled_list that logs every operation performed through it to a trace,
+// for capturing real workloads and replaying them offline (tools/trace_replay).
+//
+// Positional operations take indices rather than iterators so that recording
+// does not have to walk the list to find out where an iterator points. Reads
+// through list() are not recorded; use access() and for_each() for reads that
+// belong in the trace.
+template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>>
+class recording_unrolled_list {
+public:
+    using list_type = unrolled_list<T, NodeMaxSize, Allocator>;
+    using value_type = T;
+    using size_type = typename list_type::size_type;
+    using const_reference = typename list_type::const_reference;
+
+private:
+    list_type list_;
+    unrolled_list_trace_writer writer;
+
+public:
+    explicit recording_unrolled_list(std::ostream& trace, const Allocator& alloc = Allocator())
+        : list_(alloc), writer(trace, sizeof(T), NodeMaxSize) {}
+
+    recording_unrolled_list(const recording_unrolled_list&) = delete;
+    recording_unrolled_list& operator=(const recording_unrolled_list&) = delete;
+
+    const list_type& list() const noexcept {
+        return list_;
+    }
+
+    size_type size() const noexcept {
+        return list_.size();
+    }
+
+    bool empty() const noexcept {
+        return list_.empty();
+    }
+
+    template<typename... Args>
+    void emplace_back(Args&&... args) {
+        list_.emplace_back(std::forward<Args>(args)...);
+        writer.record(unrolled_list_trace_op::push_back);
+    }
+
+    template<typename... Args>
+    void emplace_front(Args&&... args) {
+        list_.emplace_front(std::forward<Args>(args)...);
+        writer.record(unrolled_list_trace_op::push_front);
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    void push_front(const T& value) {
+        emplace_front(value);
+    }
+
+    void push_front(T&& value) {
+        emplace_front(std::move(value));
+    }
+
+    void pop_back() {
+        if (list_.empty()) return;
+        list_.pop_back();
+        writer.record(unrolled_list_trace_op::pop_back);
+    }
+
+    void pop_front() {
+        if (list_.empty()) return;
+        list_.pop_front();
+        writer.record(unrolled_list_trace_op::pop_front);
+    }
+
+    // Insert value before the element at index, index == size() appends
+    template<typename... Args>
+    void emplace(size_type index, Args&&... args) {
+        if (index > list_.size()) throw std::out_of_range("recording_unrolled_list: index out of range");
+        list_.emplace(std::next(list_.cbegin(), index), std::forward<Args>(args)...);
+        writer.record(unrolled_list_trace_op::insert, index);
+    }
+
+    void insert(size_type index, const T& value) {
+        emplace(index, value);
+    }
+
+    void insert(size_type index, T&& value) {
+        emplace(index, std::move(value));
+    }
+
+    void erase(size_type index) {
+        if (index >= list_.size()) throw std::out_of_range("recording_unrolled_list: index out of range");
+        list_.erase(std::next(list_.cbegin(), index));
+        writer.record(unrolled_list_trace_op::erase, index);
+    }
+
+    const_reference access(size_type index) {
+        if (index >= list_.size()) throw std::out_of_range("recording_unrolled_list: index out of range");
+        writer.record(unrolled_list_trace_op::access, index);
+        return std::as_const(list_)[index];
+    }
+
+    // Call f on count elements starting at index
+    template<typename F>
+    void for_each(size_type index, size_type count, F f) {
+        if (index > list_.size() || count > list_.size() - index) {
+            throw std::out_of_range("recording_unrolled_list: range out of range");
+        }
+        writer.record(unrolled_list_trace_op::iterate, index, count);
+        auto it = std::next(list_.cbegin(), index);
+        for (size_type i = 0; i < count; ++i, ++it) f(*it);
+    }
+
+    void clear() {
+        list_.clear();
+        writer.record(unrolled_list_trace_op::clear);
+    }
+
+    // Write buffered records to the trace stream
+    void flush() {
+        writer.flush();
+    }
+
+    uint64_t record_count() const noexcept {
+        return writer.record_count();
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "unrolled_list.h"
+
+// K independent unrolled lists (shards) that different threads can append to
+// in parallel.
+//
+// Every shard sits on its own cache lines together with its own lock, so
+// threads appending to different shards share no memory at all. A thread
+// that owns a shard outright can skip the lock through shard(). The logical
+// order of the whole list is shard 0 followed by shard 1 and so on, and
+// flatten() splices all shards into one unrolled_list in O(K) without moving
+// any element.
+template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>>
+class sharded_unrolled_list {
+public:
+    using list_type = unrolled_list<T, NodeMaxSize, Allocator>;
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+
+private:
+    struct alignas(64) Shard {
+        std::mutex mutex; // Guards list for push_back/emplace_back
+        list_type list;
+
+        explicit Shard(const Allocator& alloc) : list(alloc) {}
+    };
+
+    using ShardAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Shard>;
+    using ShardAllocatorTraits = std::allocator_traits<ShardAllocator>;
+
+    Shard* shards; // shard_count_ shards, each constructed with allocator
+    size_type shard_count_;
+    Allocator allocator;
+
+    void destroy_shards(size_type count) noexcept {
+        ShardAllocator shard_allocator(allocator);
+        for (size_type i = 0; i < count; ++i) {
+            ShardAllocatorTraits::destroy(shard_allocator, shards + i);
+        }
+        ShardAllocatorTraits::deallocate(shard_allocator, shards, shard_count_);
+    }
+
+public:
+    explicit sharded_unrolled_list(size_type shard_count = std::thread::hardware_concurrency(),
+                                   const Allocator& alloc = Allocator())
+        : shards(nullptr), shard_count_(shard_count > 0 ? shard_count : 1), allocator(alloc) {
+        ShardAllocator shard_allocator(allocator);
+        shards = ShardAllocatorTraits::allocate(shard_allocator, shard_count_);
+        size_type constructed = 0;
+        try {
+            for (; constructed < shard_count_; ++constructed) {
+                ShardAllocatorTraits::construct(shard_allocator, shards + constructed, alloc);
+            }
+        } catch (...) {
+            destroy_shards(constructed);
+            throw;
+        }
+    }
+
+    ~sharded_unrolled_list() {
+        destroy_shards(shard_count_);
+    }
+
+    sharded_unrolled_list(const sharded_unrolled_list&) = delete;
+    sharded_unrolled_list& operator=(const sharded_unrolled_list&) = delete;
+
+    allocator_type get_allocator() const noexcept {
+        return allocator;
+    }
+
+    // Shard selection
+    size_type shard_count() const noexcept {
+        return shard_count_;
+    }
+
+    // Stable shard of the calling thread
+    size_type this_thread_shard() const noexcept {
+        return std::hash<std::thread::id>()(std::this_thread::get_id()) % shard_count_;
+    }
+
+    // Shard of a key, for per-key ordering
+    template<typename Key>
+    size_type shard_of(const Key& key) const {
+        return std::hash<Key>()(key) % shard_count_;
+    }
+
+    // Unlocked access for the thread that owns shard index
+    list_type& shard(size_type index) noexcept {
+        return shards[index].list;
+    }
+
+    const list_type& shard(size_type index) const noexcept {
+        return shards[index].list;
+    }
+
+    // Appends under the shard's own lock, safe from any thread
+    void push_back(size_type index, const T& value) {
+        emplace_back(index, value);
+    }
+
+    void push_back(size_type index, T&& value) {
+        emplace_back(index, std::move(value));
+    }
+
+    template<typename... Args>
+    void emplace_back(size_type index, Args&&... args) {
+        std::lock_guard<std::mutex> guard(shards[index].mutex);
+        shards[index].list.emplace_back(std::forward<Args>(args)...);
+    }
+
+    // Whole-list operations, not synchronized with concurrent appends
+    size_type size() const noexcept {
+        size_type total = 0;
+        for (size_type i = 0; i < shard_count_; ++i) {
+            total += shards[i].list.size();
+        }
+        return total;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Call f on every element in logical order
+    template<typename F>
+    void for_each(F f) const {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            for (const T& item : shards[i].list) {
+                f(item);
+            }
+        }
+    }
+
+    // Splice every shard, in order, into one list and leave the shards empty
+    list_type flatten() {
+        list_type result(allocator);
+        for (size_type i = 0; i < shard_count_; ++i) {
+            result.splice(result.end(), shards[i].list);
+        }
+        return result;
+    }
+
+    void clear() noexcept {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            shards[i].list.clear();
+        }
+    }
+};
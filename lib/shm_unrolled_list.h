@@ -0,0 +1,391 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Unrolled list placed in a POSIX shared memory segment, for handing batches
+// of records from one process to another without copying them.
+//
+// The segment holds a header and a fixed pool of nodes linked by offsets from
+// the start of the segment, so every process can map it at its own address.
+// A producer takes a free node, fills it in place and publishes it at the
+// tail of the list. A consumer takes the head node, reads the elements where
+// they are and releases the node back to the pool. The list and the pool are
+// guarded by a process-shared mutex, and two process-shared condition
+// variables wake consumers when a node is published and producers when one
+// is released. The lock is taken once per node, never per element.
+template<typename T, size_t NodeMaxSize = 256>
+class shm_unrolled_list {
+    static_assert(std::is_trivially_copyable_v<T>, "shm_unrolled_list stores elements as raw bytes");
+
+private:
+    using Offset = uint64_t; // Byte offset in the segment, 0 is the null offset
+
+    struct Node {
+        Offset next; // Offset of the next node
+        uint64_t size; // Current number of elements
+        T data[NodeMaxSize]; // Array of elements
+    };
+
+    // Stored at offset 0 of the segment
+    struct SegmentHeader {
+        uint32_t magic; // SegmentMagic
+        uint32_t element_size; // sizeof(T)
+        uint64_t node_max_size; // NodeMaxSize
+        uint64_t node_capacity; // Nodes in the pool
+        pthread_mutex_t mutex; // Guards everything below
+        pthread_cond_t published; // Signalled when a node is published or the list is closed
+        pthread_cond_t released; // Signalled when a node returns to the pool
+        Offset free_head; // First free node, linked through next
+        Offset head; // First published node
+        Offset tail; // Last published node
+        uint64_t size; // Elements in published nodes
+        uint64_t node_count; // Published nodes
+        bool closed; // No more nodes will be published
+    };
+
+    static constexpr uint32_t SegmentMagic = 0x53534c55; // "ULSS"
+    static constexpr size_t NodeAlign = alignof(Node) > 64 ? alignof(Node) : 64;
+    static constexpr size_t NodeStride = (sizeof(Node) + NodeAlign - 1) / NodeAlign * NodeAlign;
+    static constexpr size_t FirstNode = (sizeof(SegmentHeader) + NodeAlign - 1) / NodeAlign * NodeAlign;
+
+    unsigned char* base;
+    size_t length;
+
+    shm_unrolled_list(unsigned char* base, size_t length) : base(base), length(length) {}
+
+    SegmentHeader& header() const noexcept {
+        return *reinterpret_cast<SegmentHeader*>(base);
+    }
+
+    Node* node_at(Offset offset) const noexcept {
+        return reinterpret_cast<Node*>(base + offset);
+    }
+
+    static size_t segment_length(size_t node_capacity) {
+        return FirstNode + node_capacity * NodeStride;
+    }
+
+    static void check(int result, const char* what) {
+        if (result != 0) throw std::system_error(result, std::generic_category(), what);
+    }
+
+    class lock {
+    private:
+        pthread_mutex_t* mutex;
+
+    public:
+        explicit lock(pthread_mutex_t& mutex) : mutex(&mutex) {
+            check(pthread_mutex_lock(this->mutex), "shm_unrolled_list: pthread_mutex_lock");
+        }
+
+        ~lock() {
+            pthread_mutex_unlock(mutex);
+        }
+
+        lock(const lock&) = delete;
+        lock& operator=(const lock&) = delete;
+    };
+
+    // Pop a node off the free list, 0 if the pool is empty. Caller holds the mutex.
+    Offset take_free() noexcept {
+        SegmentHeader& shared = header();
+        Offset offset = shared.free_head;
+        if (offset) {
+            shared.free_head = node_at(offset)->next;
+            node_at(offset)->next = 0;
+            node_at(offset)->size = 0;
+        }
+        return offset;
+    }
+
+    void release(Offset offset) noexcept {
+        SegmentHeader& shared = header();
+        pthread_mutex_lock(&shared.mutex);
+        node_at(offset)->next = shared.free_head;
+        shared.free_head = offset;
+        pthread_mutex_unlock(&shared.mutex);
+        pthread_cond_signal(&shared.released);
+    }
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+
+    // A node owned by one process: being filled by a producer or read by a
+    // consumer. Dropping it without publish() returns the node to the pool.
+    class node_handle {
+    private:
+        shm_unrolled_list* list;
+        Offset offset;
+
+        friend class shm_unrolled_list;
+
+        node_handle(shm_unrolled_list* list, Offset offset) : list(list), offset(offset) {}
+
+        Node* node() const noexcept { return list->node_at(offset); }
+
+    public:
+        node_handle() : list(nullptr), offset(0) {}
+
+        node_handle(node_handle&& other) noexcept
+            : list(other.list), offset(std::exchange(other.offset, 0)) {}
+
+        node_handle& operator=(node_handle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                list = other.list;
+                offset = std::exchange(other.offset, 0);
+            }
+            return *this;
+        }
+
+        ~node_handle() {
+            reset();
+        }
+
+        // Give the node back to the pool
+        void reset() noexcept {
+            if (offset) list->release(std::exchange(offset, 0));
+        }
+
+        explicit operator bool() const noexcept { return offset != 0; }
+
+        size_type size() const noexcept { return node()->size; }
+        static constexpr size_type capacity() noexcept { return NodeMaxSize; }
+        bool full() const noexcept { return node()->size == NodeMaxSize; }
+        bool empty() const noexcept { return node()->size == 0; }
+
+        T* data() noexcept { return node()->data; }
+        const T* data() const noexcept { return node()->data; }
+
+        std::span<T> elements() noexcept { return {node()->data, node()->size}; }
+        std::span<const T> elements() const noexcept { return {node()->data, node()->size}; }
+
+        // Append in place, the node must not be full
+        void push_back(const T& value) noexcept {
+            Node* target = node();
+            target->data[target->size++] = value;
+        }
+
+        // Set the element count after writing through data() directly
+        void resize(size_type count) noexcept {
+            node()->size = count;
+        }
+    };
+
+    // Creates a segment with a pool of node_capacity nodes. Fails if a
+    // segment with that name exists, see unlink().
+    static shm_unrolled_list create(const std::string& name, size_type node_capacity) {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "shm_unrolled_list: shm_open " + name);
+
+        size_t length = segment_length(node_capacity);
+        void* addr = MAP_FAILED;
+        if (::ftruncate(fd, off_t(length)) == 0) {
+            addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int error = errno;
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            ::shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "shm_unrolled_list: map " + name);
+        }
+
+        shm_unrolled_list list(static_cast<unsigned char*>(addr), length);
+        SegmentHeader& shared = list.header();
+        shared.element_size = sizeof(T);
+        shared.node_max_size = NodeMaxSize;
+        shared.node_capacity = node_capacity;
+        shared.free_head = 0;
+        shared.head = 0;
+        shared.tail = 0;
+        shared.size = 0;
+        shared.node_count = 0;
+        shared.closed = false;
+        for (size_type i = node_capacity; i > 0; --i) {
+            Offset offset = FirstNode + (i - 1) * NodeStride;
+            list.node_at(offset)->next = shared.free_head;
+            shared.free_head = offset;
+        }
+
+        pthread_mutexattr_t mutex_attr;
+        pthread_mutexattr_init(&mutex_attr);
+        pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutex_init(&shared.mutex, &mutex_attr);
+        pthread_mutexattr_destroy(&mutex_attr);
+
+        pthread_condattr_t cond_attr;
+        pthread_condattr_init(&cond_attr);
+        pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+        pthread_cond_init(&shared.published, &cond_attr);
+        pthread_cond_init(&shared.released, &cond_attr);
+        pthread_condattr_destroy(&cond_attr);
+
+        // Opening processes check the magic last
+        __atomic_store_n(&shared.magic, SegmentMagic, __ATOMIC_RELEASE);
+        return list;
+    }
+
+    // Maps an existing segment created by create()
+    static shm_unrolled_list open(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "shm_unrolled_list: shm_open " + name);
+
+        struct stat info;
+        void* addr = MAP_FAILED;
+        if (::fstat(fd, &info) == 0) {
+            addr = ::mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int error = errno;
+        ::close(fd);
+        if (addr == MAP_FAILED) throw std::system_error(error, std::generic_category(), "shm_unrolled_list: map " + name);
+
+        shm_unrolled_list list(static_cast<unsigned char*>(addr), size_t(info.st_size));
+        const SegmentHeader& shared = list.header();
+        if (list.length < sizeof(SegmentHeader) ||
+            __atomic_load_n(&shared.magic, __ATOMIC_ACQUIRE) != SegmentMagic) {
+            throw std::runtime_error("shm_unrolled_list: segment is not initialized");
+        }
+        if (shared.element_size != sizeof(T) || shared.node_max_size != NodeMaxSize ||
+            list.length < segment_length(shared.node_capacity)) {
+            throw std::runtime_error("shm_unrolled_list: segment was created with a different layout");
+        }
+        return list;
+    }
+
+    // Removes the name, processes that mapped the segment keep using it
+    static void unlink(const std::string& name) noexcept {
+        ::shm_unlink(name.c_str());
+    }
+
+    shm_unrolled_list(const shm_unrolled_list&) = delete;
+    shm_unrolled_list& operator=(const shm_unrolled_list&) = delete;
+
+    shm_unrolled_list(shm_unrolled_list&& other) noexcept
+        : base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)) {}
+
+    shm_unrolled_list& operator=(shm_unrolled_list&& other) noexcept {
+        if (this != &other) {
+            if (base) ::munmap(base, length);
+            base = std::exchange(other.base, nullptr);
+            length = std::exchange(other.length, 0);
+        }
+        return *this;
+    }
+
+    // Unmaps the segment in this process, handles must be gone by then
+    ~shm_unrolled_list() {
+        if (base) ::munmap(base, length);
+    }
+
+    // Producer
+    // Take an empty node from the pool, waiting for a consumer to release
+    // one if the pool is exhausted
+    node_handle acquire() {
+        SegmentHeader& shared = header();
+        lock guard(shared.mutex);
+        Offset offset;
+        while (!(offset = take_free())) {
+            check(pthread_cond_wait(&shared.released, &shared.mutex), "shm_unrolled_list: pthread_cond_wait");
+        }
+        return node_handle(this, offset);
+    }
+
+    // Empty handle if the pool is exhausted
+    node_handle try_acquire() {
+        lock guard(header().mutex);
+        Offset offset = take_free();
+        return offset ? node_handle(this, offset) : node_handle();
+    }
+
+    // Link the node at the tail of the list, empty nodes go back to the pool
+    void publish(node_handle&& node) {
+        if (!node) return;
+        if (node.empty()) {
+            node.reset();
+            return;
+        }
+        Offset offset = std::exchange(node.offset, 0);
+        SegmentHeader& shared = header();
+        {
+            lock guard(shared.mutex);
+            if (shared.tail) node_at(shared.tail)->next = offset; else shared.head = offset;
+            shared.tail = offset;
+            shared.size += node_at(offset)->size;
+            ++shared.node_count;
+        }
+        pthread_cond_signal(&shared.published);
+    }
+
+    // Wake every waiting consumer, consume() returns an empty handle once
+    // the list is drained
+    void close() {
+        SegmentHeader& shared = header();
+        {
+            lock guard(shared.mutex);
+            shared.closed = true;
+        }
+        pthread_cond_broadcast(&shared.published);
+    }
+
+    // Consumer
+    // Unlink the head node, waiting for one to be published. Empty handle
+    // once the list is closed and drained.
+    node_handle consume() {
+        SegmentHeader& shared = header();
+        lock guard(shared.mutex);
+        while (!shared.head && !shared.closed) {
+            check(pthread_cond_wait(&shared.published, &shared.mutex), "shm_unrolled_list: pthread_cond_wait");
+        }
+        return unlink_head();
+    }
+
+    // Empty handle if no node is published
+    node_handle try_consume() {
+        lock guard(header().mutex);
+        return unlink_head();
+    }
+
+    // Snapshot of the shared counters
+    size_type size() const {
+        lock guard(header().mutex);
+        return header().size;
+    }
+
+    size_type node_count() const {
+        lock guard(header().mutex);
+        return header().node_count;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    // Caller holds the mutex
+    node_handle unlink_head() noexcept {
+        SegmentHeader& shared = header();
+        Offset offset = shared.head;
+        if (!offset) return node_handle();
+        shared.head = node_at(offset)->next;
+        if (!shared.head) shared.tail = 0;
+        shared.size -= node_at(offset)->size;
+        --shared.node_count;
+        node_at(offset)->next = 0;
+        return node_handle(this, offset);
+    }
+};
@@ -0,0 +1,474 @@
+#pragma once
+
+#include <memory>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "unrolled_list_locate.h"
+
+// Unrolled list that can hold more data than fits in memory.
+//
+// Node headers always stay in memory, element blocks only while they are
+// resident. The resident blocks form an LRU, and when they would exceed the
+// memory budget the least recently used one is evicted: written to its slot
+// in a spill file if it changed since it was last read, then freed. Touching
+// an evicted node reads its block back. Forward iteration asks the kernel to
+// prefetch the spilled blocks of the next few nodes, so a sequential scan
+// overlaps reading with processing. Elements must be trivially copyable.
+//
+// References and pointers to elements are only guaranteed until the next
+// access to another node, which may evict theirs.
+template<typename T, size_t NodeMaxSize = 1024, typename Allocator = std::allocator<T>>
+class spilling_unrolled_list {
+    static_assert(std::is_trivially_copyable_v<T>, "spilling_unrolled_list spills elements as raw bytes");
+
+public:
+    // Counters since construction or the last reset_stats()
+    struct spill_stats {
+        size_t hits = 0; // Node accesses that found the block resident
+        size_t misses = 0; // Node accesses that read the block back
+        size_t evictions = 0; // Blocks dropped from memory
+        size_t prefetches = 0; // Blocks the kernel was asked to read ahead
+        size_t bytes_read = 0; // Bytes read from the spill file
+        size_t bytes_written = 0; // Bytes written to the spill file
+
+        double hit_rate() const noexcept {
+            size_t accesses = hits + misses;
+            return accesses ? double(hits) / double(accesses) : 1.0;
+        }
+    };
+
+private:
+    static constexpr size_t BlockBytes = NodeMaxSize * sizeof(T);
+    static constexpr size_t NoSlot = size_t(-1);
+    static constexpr size_t MinResident = 2;
+
+    struct Node {
+        Node* next; // Pointer to the next node
+        Node* prev; // Pointer to the previous node
+        size_t size; // Current number of elements
+        T* data; // Resident element block, nullptr while evicted
+        size_t slot; // Block index in the spill file, NoSlot until first evicted
+        bool dirty; // Block changed since it was last written
+        Node* lru_prev; // More recently used resident node
+        Node* lru_next; // Less recently used resident node
+
+        Node() : next(nullptr), prev(nullptr), size(0), data(nullptr), slot(NoSlot), dirty(true),
+                 lru_prev(nullptr), lru_next(nullptr) {}
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+    using BlockAllocatorTraits = std::allocator_traits<Allocator>;
+
+    Node* head;
+    Node* tail;
+    size_t size_;
+    NodeAllocator node_allocator;
+
+    // Block cache, changed by const accesses as well
+    mutable Allocator block_allocator;
+    mutable Node* lru_head; // Most recently used resident node
+    mutable Node* lru_tail; // Least recently used resident node
+    mutable size_t resident;
+    mutable spill_stats stats_;
+    size_t max_resident;
+    size_t prefetch_distance;
+
+    // Spill file
+    int fd;
+    mutable size_t slot_count; // Slots handed out so far
+    mutable std::vector<size_t> free_slots; // Slots of destroyed nodes
+
+    void lru_unlink(Node* node) const noexcept {
+        if (node->lru_prev) node->lru_prev->lru_next = node->lru_next; else lru_head = node->lru_next;
+        if (node->lru_next) node->lru_next->lru_prev = node->lru_prev; else lru_tail = node->lru_prev;
+        node->lru_prev = nullptr;
+        node->lru_next = nullptr;
+    }
+
+    void lru_push_front(Node* node) const noexcept {
+        node->lru_next = lru_head;
+        if (lru_head) lru_head->lru_prev = node; else lru_tail = node;
+        lru_head = node;
+    }
+
+    // Spill slots are handed out on the first eviction of a node
+    size_t take_slot() const {
+        if (!free_slots.empty()) {
+            size_t slot = free_slots.back();
+            free_slots.pop_back();
+            return slot;
+        }
+        return slot_count++;
+    }
+
+    void write_block(Node* node) const {
+        const char* bytes = reinterpret_cast<const char*>(node->data);
+        size_t done = 0;
+        while (done < node->size * sizeof(T)) {
+            ssize_t written = ::pwrite(fd, bytes + done, node->size * sizeof(T) - done,
+                                       off_t(node->slot * BlockBytes + done));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "spilling_unrolled_list: pwrite");
+            }
+            done += size_t(written);
+        }
+        stats_.bytes_written += done;
+    }
+
+    void read_block(Node* node) const {
+        char* bytes = reinterpret_cast<char*>(node->data);
+        size_t done = 0;
+        while (done < node->size * sizeof(T)) {
+            ssize_t got = ::pread(fd, bytes + done, node->size * sizeof(T) - done,
+                                  off_t(node->slot * BlockBytes + done));
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "spilling_unrolled_list: pread");
+            }
+            if (got == 0) throw std::runtime_error("spilling_unrolled_list: spill file is truncated");
+            done += size_t(got);
+        }
+        stats_.bytes_read += done;
+    }
+
+    // Write back and free the least recently used block
+    void evict_one() const {
+        Node* victim = lru_tail;
+        if (victim->dirty && victim->size > 0) {
+            if (victim->slot == NoSlot) {
+                victim->slot = take_slot();
+            }
+            write_block(victim);
+        }
+        lru_unlink(victim);
+        BlockAllocatorTraits::deallocate(block_allocator, victim->data, NodeMaxSize);
+        victim->data = nullptr;
+        victim->dirty = false;
+        --resident;
+        ++stats_.evictions;
+    }
+
+    // Make room so one more block fits in the budget
+    void reserve_block() const {
+        while (resident >= max_resident) evict_one();
+    }
+
+    // Make the block of node resident and most recently used
+    T* touch(Node* node) const {
+        if (node->data) {
+            ++stats_.hits;
+            if (node != lru_head) {
+                lru_unlink(node);
+                lru_push_front(node);
+            }
+            return node->data;
+        }
+
+        ++stats_.misses;
+        reserve_block();
+        node->data = BlockAllocatorTraits::allocate(block_allocator, NodeMaxSize);
+        try {
+            read_block(node);
+        } catch (...) {
+            BlockAllocatorTraits::deallocate(block_allocator, node->data, NodeMaxSize);
+            node->data = nullptr;
+            throw;
+        }
+        node->dirty = false;
+        lru_push_front(node);
+        ++resident;
+        return node->data;
+    }
+
+    // Same for a node about to be modified
+    T* touch_dirty(Node* node) {
+        T* data = touch(node);
+        node->dirty = true;
+        return data;
+    }
+
+    // Ask the kernel to read ahead the spilled blocks of the nodes after node
+    void prefetch_after(const Node* node) const {
+#ifdef POSIX_FADV_WILLNEED
+        for (size_t i = 0; i < prefetch_distance && node; ++i) {
+            node = node->next;
+            if (node && !node->data && node->slot != NoSlot) {
+                ::posix_fadvise(fd, off_t(node->slot * BlockBytes), off_t(node->size * sizeof(T)),
+                                POSIX_FADV_WILLNEED);
+                ++stats_.prefetches;
+            }
+        }
+#else
+        (void)node;
+#endif
+    }
+
+    // Create a resident node linked between prev and next
+    Node* create_node(Node* prev, Node* next) {
+        reserve_block();
+        Node* node = NodeAllocatorTraits::allocate(node_allocator, 1);
+        try {
+            NodeAllocatorTraits::construct(node_allocator, node);
+            node->data = BlockAllocatorTraits::allocate(block_allocator, NodeMaxSize);
+        } catch (...) {
+            NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+            throw;
+        }
+        lru_push_front(node);
+        ++resident;
+
+        node->prev = prev;
+        node->next = next;
+        if (prev) prev->next = node; else head = node;
+        if (next) next->prev = node; else tail = node;
+        return node;
+    }
+
+    void destroy_node(Node* node) noexcept {
+        if (node->prev) node->prev->next = node->next; else head = node->next;
+        if (node->next) node->next->prev = node->prev; else tail = node->prev;
+        if (node->data) {
+            lru_unlink(node);
+            BlockAllocatorTraits::deallocate(block_allocator, node->data, NodeMaxSize);
+            --resident;
+        }
+        if (node->slot != NoSlot) free_slots.push_back(node->slot);
+        NodeAllocatorTraits::destroy(node_allocator, node);
+        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+    }
+
+    // Node and position of the element at index, index == size maps to the end
+    // of the tail. Headers stay in memory, so this never loads a block.
+    std::pair<Node*, size_t> locate(size_t index) const noexcept {
+        return unrolled_list_locate(head, tail, size_, index,
+            [](const Node* node) { return node->size; }, [](const Node* node) { return node->next; });
+    }
+
+    // Free every node and forget the spill slots, the file keeps its size
+    void destroy_nodes() noexcept {
+        while (tail) destroy_node(tail);
+        size_ = 0;
+        slot_count = 0;
+        free_slots.clear();
+    }
+
+    static int open_spill_file(const std::string& directory) {
+        std::string pattern = directory + "/unrolled_list_spill_XXXXXX";
+        int fd = ::mkstemp(pattern.data());
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "spilling_unrolled_list: mkstemp " + pattern);
+        }
+        ::unlink(pattern.c_str()); // Removed by the system once closed
+        return fd;
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    // Forward iterator that faults blocks in as it reaches them and prefetches
+    // the nodes ahead of it
+    class const_iterator {
+    private:
+        const spilling_unrolled_list* list;
+        Node* current_node; // Pointer to current node, nullptr at the end
+        size_t current_pos; // Current position in node's element array
+        const T* current_data; // Block of current_node, resident while it is current
+
+        void enter(Node* node) {
+            current_node = node;
+            current_pos = 0;
+            current_data = nullptr;
+            if (node) {
+                current_data = list->touch(node);
+                list->prefetch_after(node);
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() : list(nullptr), current_node(nullptr), current_pos(0), current_data(nullptr) {}
+
+        const_iterator(const spilling_unrolled_list* list, Node* node) : list(list) {
+            enter(node);
+        }
+
+        reference operator*() const {
+            return current_data[current_pos];
+        }
+
+        pointer operator->() const {
+            return current_data + current_pos;
+        }
+
+        const_iterator& operator++() {
+            if (++current_pos == current_node->size) enter(current_node->next);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return current_node == other.current_node && current_pos == other.current_pos;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // memory_budget bounds the bytes of resident element blocks, at least
+    // two blocks are always kept. The spill file is created, already
+    // unlinked, in spill_directory.
+    explicit spilling_unrolled_list(size_type memory_budget, const std::string& spill_directory = "/tmp",
+                                    size_type prefetch_distance = 4, const Allocator& alloc = Allocator())
+        : head(nullptr), tail(nullptr), size_(0), node_allocator(alloc), block_allocator(alloc),
+          lru_head(nullptr), lru_tail(nullptr), resident(0),
+          max_resident(std::max(memory_budget / BlockBytes, MinResident)),
+          prefetch_distance(prefetch_distance), fd(open_spill_file(spill_directory)), slot_count(0) {}
+
+    spilling_unrolled_list(const spilling_unrolled_list&) = delete;
+    spilling_unrolled_list& operator=(const spilling_unrolled_list&) = delete;
+
+    // The spill file is unlinked, closing it releases its blocks
+    ~spilling_unrolled_list() {
+        destroy_nodes();
+        ::close(fd);
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return block_allocator;
+    }
+
+    // Element access, faulting the node in if needed
+    reference operator[](size_type pos) {
+        auto [node, offset] = locate(pos);
+        return touch_dirty(node)[offset];
+    }
+
+    const_reference operator[](size_type pos) const {
+        auto [node, offset] = locate(pos);
+        return touch(node)[offset];
+    }
+
+    reference at(size_type pos) {
+        if (pos >= size_) throw std::out_of_range("spilling_unrolled_list::at");
+        return (*this)[pos];
+    }
+
+    const_reference at(size_type pos) const {
+        if (pos >= size_) throw std::out_of_range("spilling_unrolled_list::at");
+        return (*this)[pos];
+    }
+
+    const_reference front() const { return touch(head)[0]; }
+    const_reference back() const { return touch(tail)[tail->size - 1]; }
+
+    // Iterators
+    const_iterator begin() const { return const_iterator(this, head); }
+    const_iterator end() const noexcept { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Size
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+
+    // Memory
+    size_type resident_nodes() const noexcept { return resident; }
+    size_type max_resident_nodes() const noexcept { return max_resident; }
+    size_type spill_file_size() const noexcept { return slot_count * BlockBytes; }
+
+    const spill_stats& stats() const noexcept { return stats_; }
+    void reset_stats() noexcept { stats_ = spill_stats(); }
+
+    // Modifiers
+
+    // Also gives the spill file's blocks back to the file system. If that
+    // fails the list is still empty and later spills reuse the file from its
+    // start.
+    void clear() {
+        destroy_nodes();
+        if (::ftruncate(fd, 0) != 0) {
+            throw std::system_error(errno, std::generic_category(), "spilling_unrolled_list: ftruncate");
+        }
+    }
+
+    void push_back(const T& value) { insert(size_, value); }
+    void push_front(const T& value) { insert(0, value); }
+
+    void pop_back() { erase(size_ - 1); }
+    void pop_front() { erase(0); }
+
+    // Insert before the element at pos, pos == size() appends
+    void insert(size_type pos, const T& value) {
+        T copy = value; // value may live in a block that gets evicted
+        auto [node, offset] = locate(pos);
+        if (!node || (pos == size_ && node->size == NodeMaxSize)) {
+            // A full tail is not split for an append, which would dirty its
+            // block and leave two half-full blocks to spill
+            node = create_node(tail, nullptr);
+            offset = 0;
+        } else if (node->size == NodeMaxSize) {
+            // Load and dirty the full node's block, then copy its upper half
+            // into the block of a new node after it
+            touch_dirty(node);
+            size_t half = NodeMaxSize / 2;
+            Node* back = create_node(node, node->next);
+            std::memcpy(back->data, node->data + half, (node->size - half) * sizeof(T));
+            back->size = node->size - half;
+            node->size = half;
+            if (offset > half) {
+                node = back;
+                offset -= half;
+            }
+        }
+
+        T* data = touch_dirty(node);
+        std::memmove(data + offset + 1, data + offset, (node->size - offset) * sizeof(T));
+        data[offset] = copy;
+        ++node->size;
+        ++size_;
+    }
+
+    void erase(size_type pos) {
+        auto [node, offset] = locate(pos);
+        if (node->size == 1) {
+            destroy_node(node);
+        } else {
+            T* data = touch_dirty(node);
+            std::memmove(data + offset, data + offset + 1, (node->size - offset - 1) * sizeof(T));
+            --node->size;
+        }
+        --size_;
+    }
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// Lock-free single-producer/single-consumer queue built on a chain of unrolled
+// nodes.
+//
+// The producer fills the tail node and publishes every element through the
+// node's committed count (release), the consumer drains the head node and
+// acquires that count. Nodes the consumer has left behind are handed back to
+// the producer, which relinks them at the tail instead of allocating, so a
+// queue in steady state does no allocation at all.
+template<typename T, size_t NodeMaxSize = 64, typename Allocator = std::allocator<T>>
+class spsc_unrolled_queue {
+private:
+    struct Node {
+        std::atomic<size_t> committed; // Number of published elements
+        std::atomic<Node*> next; // Pointer to the next node
+        alignas(T) unsigned char storage[NodeMaxSize * sizeof(T)]; // Array of elements
+
+        Node() : committed(0), next(nullptr) {}
+
+        T* data() { return reinterpret_cast<T*>(storage); }
+    };
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
+    static constexpr size_t CacheLine = 64;
+
+    // Producer side
+    alignas(CacheLine) Node* tail; // Node being filled
+    size_t tail_pos; // Producer's copy of tail->committed
+    Node* first; // Oldest node, recycled once the consumer has left it
+    Node* consumer_copy; // Last seen value of consumer_node
+    NodeAllocator node_allocator;
+
+    // Consumer side
+    alignas(CacheLine) Node* head; // Node being drained
+    size_t head_pos; // Next element to read in head
+
+    // Shared: nodes before this one are free for the producer to reuse
+    alignas(CacheLine) std::atomic<Node*> consumer_node;
+
+    Node* create_node() {
+        Node* node = NodeAllocatorTraits::allocate(node_allocator, 1);
+        try {
+            NodeAllocatorTraits::construct(node_allocator, node);
+        } catch (...) {
+            NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroy_node(Node* node) noexcept {
+        NodeAllocatorTraits::destroy(node_allocator, node);
+        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+    }
+
+    // Take a node the consumer has finished with, or allocate a new one
+    Node* acquire_node() {
+        if (first == consumer_copy) {
+            consumer_copy = consumer_node.load(std::memory_order_acquire);
+        }
+        if (first != consumer_copy) {
+            Node* node = first;
+            first = first->next.load(std::memory_order_relaxed);
+            node->committed.store(0, std::memory_order_relaxed);
+            node->next.store(nullptr, std::memory_order_relaxed);
+            return node;
+        }
+        return create_node();
+    }
+
+    // Element the consumer reads next, or nullptr if none is published yet.
+    // Stepping to the next node releases the drained one to the producer.
+    T* front_slot() {
+        while (head_pos >= head->committed.load(std::memory_order_acquire)) {
+            if (head_pos < NodeMaxSize) return nullptr;
+
+            Node* next = head->next.load(std::memory_order_acquire);
+            if (!next) return nullptr;
+            head = next;
+            head_pos = 0;
+            consumer_node.store(next, std::memory_order_release);
+        }
+        return head->data() + head_pos;
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+
+    explicit spsc_unrolled_queue(const Allocator& alloc = Allocator())
+        : tail_pos(0), node_allocator(alloc), head_pos(0) {
+        Node* node = create_node();
+        tail = node;
+        first = node;
+        consumer_copy = node;
+        head = node;
+        consumer_node.store(node, std::memory_order_relaxed);
+    }
+
+    spsc_unrolled_queue(const spsc_unrolled_queue&) = delete;
+    spsc_unrolled_queue& operator=(const spsc_unrolled_queue&) = delete;
+
+    // Not thread-safe, both sides must be finished
+    ~spsc_unrolled_queue() {
+        for (Node* node = head; node; node = node->next.load(std::memory_order_relaxed)) {
+            size_t end = node->committed.load(std::memory_order_relaxed);
+            for (size_t i = node == head ? head_pos : 0; i < end; ++i) {
+                node->data()[i].~T();
+            }
+        }
+        Node* node = first;
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            destroy_node(node);
+            node = next;
+        }
+    }
+
+    // Producer
+    void push(const T& value) {
+        emplace(value);
+    }
+
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        if (tail_pos == NodeMaxSize) {
+            Node* node = acquire_node();
+            try {
+                new (node->data()) T(std::forward<Args>(args)...);
+            } catch (...) {
+                destroy_node(node);
+                throw;
+            }
+            node->committed.store(1, std::memory_order_relaxed);
+            tail->next.store(node, std::memory_order_release);
+            tail = node;
+            tail_pos = 1;
+            return;
+        }
+        new (tail->data() + tail_pos) T(std::forward<Args>(args)...);
+        tail->committed.store(++tail_pos, std::memory_order_release);
+    }
+
+    // Consumer
+    bool try_pop(T& out) {
+        T* value = front_slot();
+        if (!value) return false;
+        out = std::move(*value);
+        value->~T();
+        ++head_pos;
+        return true;
+    }
+
+    std::optional<T> try_pop() {
+        T* value = front_slot();
+        if (!value) return std::nullopt;
+        std::optional<T> result(std::move(*value));
+        value->~T();
+        ++head_pos;
+        return result;
+    }
+
+    // Only meaningful from the consumer thread
+    bool empty() const {
+        if (head_pos < head->committed.load(std::memory_order_acquire)) return false;
+        return head_pos < NodeMaxSize || !head->next.load(std::memory_order_acquire);
+    }
+};
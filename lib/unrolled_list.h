@@ -1,19 +1,216 @@
+#pragma once
+
 #include <memory>
 #include <iterator>
 #include <initializer_list>
 #include <stdexcept>
 #include <type_traits>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cerrno>
+#include <istream>
+#include <ostream>
+#include <system_error>
+
+#if __has_include(<sys/uio.h>) && __has_include(<unistd.h>)
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define UNROLLED_LIST_POSIX_IO 1
+#endif
+
+// Customization point for serializing element types that are not trivially
+// copyable. Specializations provide
+//     static void write(std::ostream& out, const T& value);
+//     static T read(std::istream& in);
+template<typename T>
+struct unrolled_list_serializer;
+
+template<typename T>
+concept unrolled_list_block_serializable = std::is_trivially_copyable_v<T>;
+
+template<typename T>
+concept unrolled_list_custom_serializable = requires(std::ostream& out, std::istream& in, const T& value) {
+    unrolled_list_serializer<T>::write(out, value);
+    { unrolled_list_serializer<T>::read(in) } -> std::convertible_to<T>;
+};
+
+// Key types accepted by unrolled_list::radix_sort
+template<typename Key>
+concept radix_sort_key = (std::is_integral_v<Key> && !std::is_same_v<Key, bool>) ||
+    (std::is_floating_point_v<Key> && std::numeric_limits<Key>::is_iec559 &&
+     (sizeof(Key) == 4 || sizeof(Key) == 8));
+
+// Operations an instrumentation policy can time
+enum class unrolled_list_operation : uint8_t { emplace, erase, push_back, push_front, pop_back, pop_front };
+inline constexpr size_t unrolled_list_operation_count = 6;
+
+// Default instrumentation policy. unrolled_list calls these hooks on
+// structural events, every hook is empty and compiles away.
+struct unrolled_list_no_instrumentation {
+    // unrolled_list calls the hooks only for enabled policies, so their
+    // arguments are not even computed here
+    static constexpr bool enabled = false;
+
+    void node_created() noexcept {}
+    void node_destroyed() noexcept {}
+    void node_split(size_t /* moved */) noexcept {}
+    void lists_merged(size_t /* moved */) noexcept {}
+    void elements_shifted(size_t /* count */) noexcept {}
+
+    // Lives for the duration of one operation
+    struct timer {
+        timer(unrolled_list_no_instrumentation&, unrolled_list_operation) noexcept {}
+    };
+};
+
+// Counters collected by unrolled_list_counting_instrumentation
+struct unrolled_list_counters {
+    size_t nodes_created = 0;
+    size_t nodes_destroyed = 0;
+    size_t splits = 0; // Full nodes split to make room
+    size_t split_moves = 0; // Elements moved into the new half by splits
+    size_t merges = 0; // Calls of merge
+    size_t merge_moves = 0; // Elements moved by merge, relinked nodes excluded
+    size_t shifts = 0; // Inserts and erases that shifted elements inside a node
+    size_t shifted_elements = 0; // Elements moved by those shifts
+    // Operation latencies, bucket i counts durations in [2^(i-1), 2^i) nanoseconds
+    std::array<std::array<size_t, 64>, unrolled_list_operation_count> latency_histogram{};
+};
+
+// Counting instrumentation policy. By default every list counts into its
+// own counters. Constructed with shared counters, e.g. one global object,
+// it updates them atomically so lists on different threads can share them.
+// With Timing every operation is also timed into latency_histogram.
+template<bool Timing = false>
+class unrolled_list_counting_instrumentation {
+private:
+    unrolled_list_counters own;
+    unrolled_list_counters* shared = nullptr;
 
-template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>>
+    void add(size_t& counter, size_t value) noexcept {
+        if (shared) {
+            std::atomic_ref<size_t>(counter).fetch_add(value, std::memory_order_relaxed);
+        } else {
+            counter += value;
+        }
+    }
+
+public:
+    static constexpr bool enabled = true;
+
+    unrolled_list_counting_instrumentation() = default;
+    explicit unrolled_list_counting_instrumentation(unrolled_list_counters& counters) : shared(&counters) {}
+
+    // Read shared counters only once the lists updating them are quiescent
+    const unrolled_list_counters& counters() const noexcept { return shared ? *shared : own; }
+
+    void reset() noexcept {
+        if (shared) *shared = unrolled_list_counters(); else own = unrolled_list_counters();
+    }
+
+    void node_created() noexcept { add(target().nodes_created, 1); }
+    void node_destroyed() noexcept { add(target().nodes_destroyed, 1); }
+
+    void node_split(size_t moved) noexcept {
+        add(target().splits, 1);
+        add(target().split_moves, moved);
+    }
+
+    void lists_merged(size_t moved) noexcept {
+        add(target().merges, 1);
+        add(target().merge_moves, moved);
+    }
+
+    void elements_shifted(size_t count) noexcept {
+        if (count == 0) return;
+        add(target().shifts, 1);
+        add(target().shifted_elements, count);
+    }
+
+    class timer {
+    private:
+        unrolled_list_counting_instrumentation* policy;
+        unrolled_list_operation operation;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        timer(unrolled_list_counting_instrumentation& policy, unrolled_list_operation operation) noexcept
+            : policy(&policy), operation(operation) {
+            if constexpr (Timing) start = std::chrono::steady_clock::now();
+        }
+
+        ~timer() {
+            if constexpr (Timing) {
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                size_t bucket = std::min<size_t>(std::bit_width(uint64_t(ns)), 63);
+                policy->add(policy->target().latency_histogram[size_t(operation)][bucket], 1);
+            }
+        }
+
+        timer(const timer&) = delete;
+        timer& operator=(const timer&) = delete;
+    };
+
+private:
+    unrolled_list_counters& target() noexcept { return shared ? *shared : own; }
+};
+
+// Default checkpoint policy. Nodes carry no modification state, so accessors
+// and structural operations pay nothing, and checkpoint() is not available.
+struct unrolled_list_no_checkpoints {
+    static constexpr bool enabled = false;
+};
+
+// Checkpoint policy. Every node carries an id and the checkpoint clock value
+// of its last modification, which checkpoint() compares to find the nodes
+// changed since the previous record.
+struct unrolled_list_checkpoints {
+    static constexpr bool enabled = true;
+};
+
+template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>,
+         typename Instrumentation = unrolled_list_no_instrumentation,
+         typename Checkpointing = unrolled_list_no_checkpoints>
 class unrolled_list {
 private:
+    struct NoCheckpointState {};
+
+    struct NodeCheckpointState {
+        uint64_t id = 0; // Unique among all lists of this type, names the node in checkpoints
+        uint64_t generation = 0; // Checkpoint clock at the last modification
+    };
+
+    struct ListCheckpointState {
+        uint64_t generation = 0; // Clock value taken by the last checkpoint
+        std::vector<uint64_t> ids; // Node ids in list order at the last checkpoint
+    };
+
+    // Empty unless Checkpointing is enabled
+    using NodeCheckpoint = std::conditional_t<Checkpointing::enabled, NodeCheckpointState, NoCheckpointState>;
+    using ListCheckpoint = std::conditional_t<Checkpointing::enabled, ListCheckpointState, NoCheckpointState>;
+
     struct Node {
         size_t size; // Current number of elements
         Node* next; // Pointer to the next node
         Node* prev; // Pointer to the previous node
         Allocator element_allocator; // Allocator for elements
         T* data; // Array of elements
+        [[no_unique_address]] NodeCheckpoint checkpoint;
 
         // Node constructor
         explicit Node(const Allocator& allocator)
@@ -42,8 +239,10 @@ private:
             ++size;
         }
 
-        // Insert element at position
-        void insert(size_t pos, const T& value) {
+        // Insert element at position. Every shift inside a node goes through
+        // insert and erase, which report it to the list's instrumentation.
+        void insert(size_t pos, const T& value, Instrumentation& instrumentation) {
+            if constexpr (Instrumentation::enabled) instrumentation.elements_shifted(size - pos);
             for (size_t i = size; i > pos; --i) {
                 data[i] = std::move(data[i - 1]);
             }
@@ -52,7 +251,8 @@ private:
         }
 
         // Insert with move
-        void insert(size_t pos, T&& value) {
+        void insert(size_t pos, T&& value, Instrumentation& instrumentation) {
+            if constexpr (Instrumentation::enabled) instrumentation.elements_shifted(size - pos);
             for (size_t i = size; i > pos; --i) {
                 data[i] = std::move(data[i - 1]);
             }
@@ -61,7 +261,8 @@ private:
         }
 
         // Remove element at position
-        void erase(size_t pos) {
+        void erase(size_t pos, Instrumentation& instrumentation) {
+            if constexpr (Instrumentation::enabled) instrumentation.elements_shifted(size - pos - 1);
             std::allocator_traits<Allocator>::destroy(element_allocator, data + pos);
             for (size_t i = pos; i < size - 1; ++i) {
                 data[i] = std::move(data[i + 1]);
@@ -82,8 +283,31 @@ private:
     size_t size_; // Total number of elements
     Allocator allocator; // Element allocator
     NodeAllocator node_allocator; // Node allocator
-    
-    Node* create_node(Node* prev_node = nullptr, Node* next_node = nullptr) {
+    [[no_unique_address]] ListCheckpoint checkpoint_; // Base of the next checkpoint record
+    // Allocator calls this list made for nodes and their element blocks. Nodes
+    // handed over by splice, merge or a staging buffer keep being counted
+    // where they were allocated, so that splice stays O(1). These back stats()
+    // and are kept whatever the instrumentation policy, at the cost of one
+    // addition next to each node allocation and release.
+    size_t allocation_count = 0;
+    size_t deallocation_count = 0;
+    [[no_unique_address]] Instrumentation instrumentation_; // Receives structural events
+
+    // Node ids and the checkpoint clock are shared by all lists of this type,
+    // so nodes moved between lists by splice or swap stay distinguishable.
+    // Only lists with checkpoints enabled use them.
+    static inline std::atomic<uint64_t> node_ids{0};
+    static inline std::atomic<uint64_t> checkpoint_clock{1};
+
+    // Record that the elements of node changed since the last checkpoint
+    static void touch(Node* node) noexcept {
+        if constexpr (Checkpointing::enabled) {
+            node->checkpoint.generation = checkpoint_clock.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Allocate a node that is not linked into the list
+    Node* allocate_node() {
         Node* new_node = NodeAllocatorTraits::allocate(node_allocator, 1);
         try {
             NodeAllocatorTraits::construct(node_allocator, new_node, allocator);
@@ -91,6 +315,25 @@ private:
             NodeAllocatorTraits::deallocate(node_allocator, new_node, 1);
             throw;
         }
+        if constexpr (Checkpointing::enabled) {
+            new_node->checkpoint.id = node_ids.fetch_add(1, std::memory_order_relaxed);
+        }
+        touch(new_node);
+        allocation_count += 2;
+        if constexpr (Instrumentation::enabled) instrumentation_.node_created();
+        return new_node;
+    }
+
+    // Release a node that is not linked into the list
+    void free_node(Node* node) noexcept {
+        deallocation_count += 2;
+        if constexpr (Instrumentation::enabled) instrumentation_.node_destroyed();
+        NodeAllocatorTraits::destroy(node_allocator, node);
+        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+    }
+
+    Node* create_node(Node* prev_node = nullptr, Node* next_node = nullptr) {
+        Node* new_node = allocate_node();
         
         new_node->prev = prev_node;
         new_node->next = next_node;
@@ -111,8 +354,363 @@ private:
         if (node == head) head = node->next;
         if (node == tail) tail = node->prev;
         
-        NodeAllocatorTraits::destroy(node_allocator, node);
-        NodeAllocatorTraits::deallocate(node_allocator, node, 1);
+        free_node(node);
+    }
+
+    // Allocate a linked chain of count empty nodes, returned in order
+    std::vector<Node*> allocate_chain(size_t count) {
+        std::vector<Node*> chain;
+        chain.reserve(count);
+        try {
+            for (size_t i = 0; i < count; ++i) {
+                Node* node = allocate_node();
+                if (!chain.empty()) {
+                    node->prev = chain.back();
+                    chain.back()->next = node;
+                }
+                chain.push_back(node);
+            }
+        } catch (...) {
+            for (Node* node : chain) free_node(node);
+            throw;
+        }
+        return chain;
+    }
+
+    // Move the elements [pos, size) of node into a new node linked right after it
+    Node* split_node(Node* node, size_t pos) {
+        Node* new_node = create_node(node, node->next);
+        if constexpr (Instrumentation::enabled) instrumentation_.node_split(node->size - pos);
+        for (size_t i = pos; i < node->size; ++i) {
+            new_node->emplace_back(std::move(node->data[i]));
+            std::allocator_traits<Allocator>::destroy(allocator, node->data + i);
+        }
+        node->size = pos;
+        touch(node);
+        return new_node;
+    }
+
+    // Single read/write cursor pass over the nodes. Elements selected by
+    // pred(last_kept, value) are destroyed, survivors are packed into full
+    // nodes and the emptied tail nodes are released. If pred throws, the
+    // remaining elements are kept, the pass is finished and the exception
+    // rethrown, so the list stays valid.
+    template<typename Pred>
+    size_t compact(Pred pred) requires std::is_nothrow_move_constructible_v<T> {
+        if (!head) return 0;
+
+        Node* write_node = head;
+        size_t write_pos = 0;
+        const T* last_kept = nullptr;
+        size_t removed = 0;
+        std::exception_ptr failure;
+
+        // Every slot between the write and the read cursor is already destroyed
+        for (Node* node = head; node; node = node->next) {
+            for (size_t i = 0; i < node->size; ++i) {
+                T* value = node->data + i;
+                bool selected = false;
+                if (!failure) {
+                    try {
+                        selected = pred(last_kept, *value);
+                    } catch (...) {
+                        failure = std::current_exception();
+                    }
+                }
+                if (selected) {
+                    std::allocator_traits<Allocator>::destroy(allocator, value);
+                    touch(node);
+                    ++removed;
+                    continue;
+                }
+                if (write_pos == NodeMaxSize) {
+                    write_node = write_node->next;
+                    write_pos = 0;
+                }
+                T* slot = write_node->data + write_pos;
+                if (slot != value) {
+                    new (slot) T(std::move(*value));
+                    std::allocator_traits<Allocator>::destroy(allocator, value);
+                    touch(write_node);
+                }
+                last_kept = slot;
+                ++write_pos;
+            }
+        }
+
+        for (Node* node = head; node != write_node; node = node->next) {
+            node->size = NodeMaxSize;
+        }
+        write_node->size = write_pos;
+
+        Node* rest = write_node->next;
+        while (rest) {
+            Node* next = rest->next;
+            rest->size = 0;
+            free_node(rest);
+            rest = next;
+        }
+        write_node->next = nullptr;
+        tail = write_node;
+
+        if (write_pos == 0) { // Nothing survived
+            free_node(write_node);
+            head = nullptr;
+            tail = nullptr;
+        }
+
+        size_ -= removed;
+        if (failure) std::rethrow_exception(failure);
+        return removed;
+    }
+
+    // Layout of the serialized header, in native byte order
+    struct SerializedHeader {
+        uint32_t magic; // SerializedMagic
+        uint16_t version; // SerializedVersion
+        uint16_t format; // SerializedBlocks or SerializedCustom
+        uint32_t element_size; // sizeof(T) for the block format, 0 otherwise
+        uint32_t node_max_size; // NodeMaxSize of the writer, informational
+        uint64_t count; // Number of elements
+    };
+    static_assert(sizeof(SerializedHeader) == 24);
+
+    static constexpr uint32_t SerializedMagic = 0x54534c55; // "ULST"
+    static constexpr uint16_t SerializedVersion = 1;
+    static constexpr uint16_t SerializedBlocks = 0;
+    static constexpr uint16_t SerializedCustom = 1;
+
+    SerializedHeader serialized_header() const {
+        bool blocks = unrolled_list_block_serializable<T>;
+        return SerializedHeader{SerializedMagic, SerializedVersion, blocks ? SerializedBlocks : SerializedCustom,
+                                blocks ? uint32_t(sizeof(T)) : 0u, uint32_t(NodeMaxSize), uint64_t(size_)};
+    }
+
+    static void check_header(const SerializedHeader& header) {
+        bool blocks = unrolled_list_block_serializable<T>;
+        if (header.magic != SerializedMagic || header.version != SerializedVersion) {
+            throw std::runtime_error("unrolled_list: not a serialized unrolled_list");
+        }
+        if (header.format != (blocks ? SerializedBlocks : SerializedCustom) ||
+            (blocks && header.element_size != sizeof(T))) {
+            throw std::runtime_error("unrolled_list: serialized element type does not match");
+        }
+    }
+
+    // Checkpoint records. A record is this header, run_count Runs describing
+    // the new node order and payload_count nodes, each a uint64_t size and
+    // its elements in the serialization format. A run either keeps length
+    // consecutive nodes of the previous record starting at base, or takes
+    // the next length payload nodes when base is NewNodes.
+    struct CheckpointHeader {
+        uint32_t magic; // CheckpointMagic
+        uint16_t version; // SerializedVersion
+        uint16_t format; // SerializedBlocks or SerializedCustom
+        uint32_t element_size; // sizeof(T) for the block format, 0 otherwise
+        uint32_t node_max_size; // NodeMaxSize, nodes are restored with their sizes
+        uint64_t count; // Number of elements
+        uint64_t run_count; // Runs that follow
+        uint64_t payload_count; // Nodes written in full
+    };
+    static_assert(sizeof(CheckpointHeader) == 40);
+
+    struct CheckpointRun {
+        uint64_t base; // First kept node of the previous record, or NewNodes
+        uint64_t length; // Number of nodes
+    };
+
+    static constexpr uint32_t CheckpointMagic = 0x4b434c55; // "ULCK"
+    static constexpr uint64_t NewNodes = ~uint64_t(0);
+
+    // Elements of one node in the serialization format
+    static void write_elements(std::ostream& out, const Node* node) {
+        if constexpr (unrolled_list_block_serializable<T>) {
+            out.write(reinterpret_cast<const char*>(node->data), std::streamsize(node->size * sizeof(T)));
+        } else {
+            for (size_t i = 0; i < node->size; ++i) {
+                unrolled_list_serializer<T>::write(out, node->data[i]);
+            }
+        }
+    }
+
+    // Fill an empty unlinked node with count elements read from in
+    static void read_elements(std::istream& in, Node* node, size_t count) {
+        if constexpr (unrolled_list_block_serializable<T>) {
+            if (in.read(reinterpret_cast<char*>(node->data), std::streamsize(count * sizeof(T)))) {
+                node->size = count;
+            }
+        } else {
+            while (node->size < count && in) {
+                node->emplace_back(unrolled_list_serializer<T>::read(in));
+            }
+        }
+        if (!in) throw std::runtime_error("unrolled_list: truncated checkpoint");
+    }
+
+    // Append full nodes at the tail and fill them straight from in with one
+    // read per node. Stops after max_count elements or at end of input and
+    // returns the number of elements read.
+    size_t read_blocks(std::istream& in, size_t max_count) requires unrolled_list_block_serializable<T> {
+        size_t total = 0;
+        while (total < max_count && in) {
+            Node* node = create_node(tail, nullptr);
+            size_t want = std::min<size_t>(max_count - total, NodeMaxSize);
+            in.read(reinterpret_cast<char*>(node->data), std::streamsize(want * sizeof(T)));
+            size_t bytes = size_t(in.gcount());
+            if (bytes % sizeof(T) != 0) {
+                destroy_node(node);
+                throw std::runtime_error("unrolled_list: input ends inside an element");
+            }
+            node->size = bytes / sizeof(T);
+            size_ += node->size;
+            total += node->size;
+            if (node->size == 0) destroy_node(node);
+        }
+        if (in.bad()) throw std::runtime_error("unrolled_list: read failed");
+        return total;
+    }
+
+#ifdef UNROLLED_LIST_POSIX_IO
+    static constexpr size_t IovBatch = IOV_MAX < 1024 ? IOV_MAX : 1024;
+
+    // writev the whole vector, resuming after partial writes
+    static void write_all(int fd, iovec* iov, size_t count) {
+        while (count > 0) {
+            ssize_t written = ::writev(fd, iov, int(std::min(count, IovBatch)));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "unrolled_list: writev");
+            }
+            size_t left = size_t(written);
+            while (count > 0 && left >= iov->iov_len) {
+                left -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (left > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                iov->iov_len -= left;
+            }
+        }
+    }
+
+    // readv into the vector until it is full or the input ends, returns bytes read
+    static size_t read_all(int fd, iovec* iov, size_t count) {
+        size_t total = 0;
+        while (count > 0) {
+            ssize_t got = ::readv(fd, iov, int(std::min(count, IovBatch)));
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "unrolled_list: readv");
+            }
+            if (got == 0) break;
+            total += size_t(got);
+            size_t left = size_t(got);
+            while (count > 0 && left >= iov->iov_len) {
+                left -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (left > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                iov->iov_len -= left;
+            }
+        }
+        return total;
+    }
+
+    // Number of nodes to fill with the next readv. Regular files are sized
+    // from the bytes left, other inputs start with one node and double the
+    // batch each time, so a short input never allocates a whole batch.
+    static size_t next_batch_nodes(int fd, size_t previous) {
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            off_t pos = ::lseek(fd, 0, SEEK_CUR);
+            if (pos >= 0) {
+                size_t left = info.st_size > pos ? size_t(info.st_size - pos) : 0;
+                size_t node_bytes = NodeMaxSize * sizeof(T);
+                return std::clamp<size_t>((left + node_bytes - 1) / node_bytes, 1, IovBatch);
+            }
+        }
+        return previous ? std::min(previous * 2, IovBatch) : 1;
+    }
+
+    // Append full nodes at the tail and fill a batch of them with each readv.
+    // Stops after max_count elements or at end of input and returns the
+    // number of elements read. With read_ahead the kernel is asked to fetch
+    // the next batch of a regular file while the current one is copied.
+    size_t read_blocks(int fd, size_t max_count, bool read_ahead = false)
+        requires unrolled_list_block_serializable<T> {
+        std::vector<iovec> iov;
+        std::vector<Node*> batch;
+
+        size_t total = 0;
+        size_t batch_nodes = 0;
+        bool at_end = false;
+        while (total < max_count && !at_end) {
+            iov.clear();
+            batch.clear();
+            batch_nodes = next_batch_nodes(fd, batch_nodes);
+            iov.reserve(batch_nodes);
+            batch.reserve(batch_nodes);
+            size_t planned = 0;
+            while (batch.size() < batch_nodes && total + planned < max_count) {
+                size_t want = std::min<size_t>(max_count - total - planned, NodeMaxSize);
+                batch.push_back(create_node(tail, nullptr));
+                iov.push_back(iovec{batch.back()->data, want * sizeof(T)});
+                planned += want;
+            }
+
+#ifdef POSIX_FADV_WILLNEED
+            if (read_ahead) {
+                off_t pos = ::lseek(fd, 0, SEEK_CUR);
+                off_t window = off_t(planned * sizeof(T));
+                if (pos >= 0) ::posix_fadvise(fd, pos + window, window, POSIX_FADV_WILLNEED);
+            }
+#endif
+
+            size_t bytes;
+            try {
+                bytes = read_all(fd, iov.data(), iov.size());
+            } catch (...) {
+                for (Node* node : batch) destroy_node(node);
+                throw;
+            }
+            if (bytes % sizeof(T) != 0) {
+                for (Node* node : batch) destroy_node(node);
+                throw std::runtime_error("unrolled_list: input ends inside an element");
+            }
+            at_end = bytes < planned * sizeof(T);
+
+            size_t elements = bytes / sizeof(T);
+            for (Node* node : batch) {
+                node->size = std::min<size_t>(elements, NodeMaxSize);
+                elements -= node->size;
+                size_ += node->size;
+                total += node->size;
+                if (node->size == 0) destroy_node(node);
+            }
+        }
+        return total;
+    }
+#endif
+
+    // Map a radix key onto unsigned bits that sort in the same order
+    template<typename Key>
+    static auto radix_key_bits(Key key) noexcept {
+        if constexpr (std::is_floating_point_v<Key>) {
+            using Bits = std::conditional_t<sizeof(Key) == 4, uint32_t, uint64_t>;
+            constexpr Bits sign = Bits(1) << (sizeof(Bits) * 8 - 1);
+            Bits bits = std::bit_cast<Bits>(key);
+            return (bits & sign) ? Bits(~bits) : Bits(bits | sign);
+        } else {
+            using Bits = std::make_unsigned_t<Key>;
+            Bits bits = static_cast<Bits>(key);
+            if constexpr (std::is_signed_v<Key>) {
+                bits ^= Bits(1) << (sizeof(Bits) * 8 - 1);
+            }
+            return bits;
+        }
     }
 
     // Iterator template class
@@ -228,6 +826,7 @@ public:
             head = other.head;
             tail = other.tail;
             size_ = other.size_;
+            checkpoint_ = std::exchange(other.checkpoint_, ListCheckpoint());
             other.head = nullptr;
             other.tail = nullptr;
             other.size_ = 0;
@@ -253,7 +852,8 @@ public:
     // Move constructor
     unrolled_list(unrolled_list&& other) noexcept
         : head(other.head), tail(other.tail), size_(other.size_), 
-          allocator(std::move(other.allocator)), node_allocator(std::move(other.node_allocator)) {
+          allocator(std::move(other.allocator)), node_allocator(std::move(other.node_allocator)),
+          checkpoint_(std::exchange(other.checkpoint_, ListCheckpoint())) {
         other.head = nullptr;
         other.tail = nullptr;
         other.size_ = 0;
@@ -306,6 +906,7 @@ public:
             head = other.head;
             tail = other.tail;
             size_ = other.size_;
+            checkpoint_ = std::exchange(other.checkpoint_, ListCheckpoint());
             other.head = nullptr;
             other.tail = nullptr;
             other.size_ = 0;
@@ -325,8 +926,19 @@ public:
         return allocator;
     }
 
+    // The instrumentation policy, it stays with the list object on swap and move
+    Instrumentation& instrumentation() noexcept {
+        return instrumentation_;
+    }
+
+    const Instrumentation& instrumentation() const noexcept {
+        return instrumentation_;
+    }
+
     // Element access
+    // Non-const access counts as a modification of the node for checkpoints
     reference front() {
+        touch(head);
         return head->data[0];
     }
 
@@ -335,6 +947,7 @@ public:
     }
 
     reference back() {
+        touch(tail);
         return tail->data[tail->size - 1];
     }
 
@@ -345,6 +958,7 @@ public:
     reference operator[](size_type pos) {
         auto it = begin();
         std::advance(it, pos);
+        touch(it.get_node());
         return *it;
     }
 
@@ -417,6 +1031,55 @@ public:
         return std::allocator_traits<NodeAllocator>::max_size(node_allocator) * NodeMaxSize;
     }
 
+    // Shape and memory of the list
+    struct list_stats {
+        size_type node_count = 0;
+        size_type element_count = 0;
+        size_type min_node_size = 0;
+        size_type max_node_size = 0;
+        double average_node_size = 0;
+        // Nodes by fill factor, bucket i counts fills in [i/10, (i+1)/10), full nodes in the last
+        std::array<size_type, 10> fill_histogram{};
+        size_type element_bytes = 0; // sizeof(T) per element
+        size_type header_bytes = 0; // Node headers
+        size_type block_bytes = 0; // Element blocks, allocated apart from the headers
+        size_type slack_bytes = 0; // Unused slots of the element blocks
+        size_type overhead_bytes = 0; // header_bytes + slack_bytes
+        // Allocator calls made by this list object since construction, two per
+        // node. Nodes taken over from another list were counted by the list
+        // that allocated them, so allocations - deallocations only equals
+        // 2 * node_count for a list that never adopted or gave away nodes.
+        size_type allocations = 0;
+        size_type deallocations = 0;
+
+        double fill_factor() const noexcept {
+            return node_count ? double(element_count) / double(node_count * NodeMaxSize) : 0;
+        }
+    };
+
+    // One pass over the node headers, O(number of nodes). Not synchronized
+    // with writers, a metrics thread must hold the lock that guards the list.
+    list_stats stats() const noexcept {
+        list_stats result;
+        result.min_node_size = head ? NodeMaxSize : 0;
+        for (const Node* node = head; node; node = node->next) {
+            ++result.node_count;
+            result.min_node_size = std::min(result.min_node_size, node->size);
+            result.max_node_size = std::max(result.max_node_size, node->size);
+            ++result.fill_histogram[std::min<size_t>(node->size * 10 / NodeMaxSize, 9)];
+        }
+        result.element_count = size_;
+        if (result.node_count) result.average_node_size = double(size_) / double(result.node_count);
+        result.element_bytes = size_ * sizeof(T);
+        result.header_bytes = result.node_count * sizeof(Node);
+        result.block_bytes = result.node_count * NodeMaxSize * sizeof(T);
+        result.slack_bytes = result.block_bytes - result.element_bytes;
+        result.overhead_bytes = result.header_bytes + result.slack_bytes;
+        result.allocations = allocation_count;
+        result.deallocations = deallocation_count;
+        return result;
+    }
+
     // Modifiers
     void clear() noexcept {
         while (head) {
@@ -458,6 +1121,7 @@ public:
     // Emplace element in-place
     template<typename... Args>
     iterator emplace(const_iterator pos, Args&&... args) {
+        typename Instrumentation::timer timer(instrumentation_, unrolled_list_operation::emplace);
         if (pos == end()) {
             emplace_back(std::forward<Args>(args)...);
             return iterator(tail, tail->size - 1);
@@ -467,27 +1131,23 @@ public:
         size_t pos_in_node = pos.get_pos();
 
         if (!node->is_full()) {
-            node->insert(pos_in_node, T(std::forward<Args>(args)...));
+            node->insert(pos_in_node, T(std::forward<Args>(args)...), instrumentation_);
+            touch(node);
             ++size_;
             return iterator(node, pos_in_node);
         }
 
-        Node* new_node = create_node(node, node->next); // Split full node
         size_t half = NodeMaxSize / 2;
-        
-        for (size_t i = half; i < NodeMaxSize; ++i) { // Move elements to new node
-            new_node->emplace_back(std::move(node->data[i]));
-            std::allocator_traits<Allocator>::destroy(allocator, node->data + i);
-        }
-        node->size = half;
-        new_node->size = NodeMaxSize - half;
+        Node* new_node = split_node(node, half); // Split full node
 
         if (pos_in_node < half) { // Insert into appropriate node
-            node->insert(pos_in_node, T(std::forward<Args>(args)...));
+            node->insert(pos_in_node, T(std::forward<Args>(args)...), instrumentation_);
+            touch(node);
             ++size_;
             return iterator(node, pos_in_node);
         } else {
-            new_node->insert(pos_in_node - half, T(std::forward<Args>(args)...));
+            new_node->insert(pos_in_node - half, T(std::forward<Args>(args)...), instrumentation_);
+            touch(new_node);
             ++size_;
             return iterator(new_node, pos_in_node - half);
         }
@@ -495,19 +1155,22 @@ public:
 
     // Erase operations
     iterator erase(const_iterator pos) noexcept {
+        typename Instrumentation::timer timer(instrumentation_, unrolled_list_operation::erase);
         Node* node = pos.get_node();
         size_t pos_in_node = pos.get_pos();
 
-        node->erase(pos_in_node);
+        node->erase(pos_in_node, instrumentation_);
+        touch(node);
         --size_;
 
-        if (node->size == 0 && node != head) {
+        if (node->size == 0) {
             Node* next_node = node->next;
             destroy_node(node);
             return iterator(next_node, 0);
         }
 
-        return iterator(node, pos_in_node < node->size ? pos_in_node : 0);
+        if (pos_in_node == node->size) return iterator(node->next, 0);
+        return iterator(node, pos_in_node);
     }
 
     iterator erase(const_iterator first, const_iterator last) noexcept {
@@ -528,6 +1191,7 @@ public:
 
     template<typename... Args>
     reference emplace_back(Args&&... args) {
+        typename Instrumentation::timer timer(instrumentation_, unrolled_list_operation::push_back);
         if (empty()) {
             create_node();
         }
@@ -537,21 +1201,22 @@ public:
         }
 
         tail->emplace_back(std::forward<Args>(args)...);
+        touch(tail);
         ++size_;
         return tail->data[tail->size - 1];
     }
 
     void pop_back() noexcept {
         if (empty()) return;
+        typename Instrumentation::timer timer(instrumentation_, unrolled_list_operation::pop_back);
 
         std::allocator_traits<Allocator>::destroy(allocator, tail->data + tail->size - 1);
         --tail->size;
+        touch(tail);
         --size_;
 
-        if (tail->size == 0 && tail != head) {
-            Node* prev = tail->prev;
+        if (tail->size == 0) {
             destroy_node(tail);
-            tail = prev;
         }
     }
 
@@ -565,6 +1230,7 @@ public:
 
     template<typename... Args>
     reference emplace_front(Args&&... args) {
+        typename Instrumentation::timer timer(instrumentation_, unrolled_list_operation::push_front);
         if (empty()) {
             create_node();
         }
@@ -574,19 +1240,18 @@ public:
             head = new_node;
         }
 
-        head->insert(0, T(std::forward<Args>(args)...));
+        head->insert(0, T(std::forward<Args>(args)...), instrumentation_);
+        touch(head);
         ++size_;
         return head->data[0];
     }
 
     void pop_front() noexcept {
         if (empty()) return;
+        typename Instrumentation::timer timer(instrumentation_, unrolled_list_operation::pop_front);
 
-        std::allocator_traits<Allocator>::destroy(allocator, head->data);
-        for (size_t i = 1; i < head->size; ++i) {
-            head->data[i - 1] = std::move(head->data[i]);
-        }
-        --head->size;
+        head->erase(0, instrumentation_);
+        touch(head);
         --size_;
 
         if (head->size == 0) {
@@ -623,6 +1288,7 @@ public:
         std::swap(size_, other.size_);
         std::swap(allocator, other.allocator);
         std::swap(node_allocator, other.node_allocator);
+        std::swap(checkpoint_, other.checkpoint_);
     }
 
     // Range operations
@@ -651,16 +1317,663 @@ public:
             ++pos;
         }
     }
+
+    // Move all elements of other in front of pos without copying them. Only
+    // the node containing pos is split when pos is inside a node.
+    // Allocators must compare equal.
+    void splice(const_iterator pos, unrolled_list& other) {
+        if (this == &other || !other.head) return;
+
+        Node* next_node = nullptr;
+        if (pos != end()) {
+            next_node = pos.get_node();
+            if (pos.get_pos() > 0) {
+                next_node = split_node(next_node, pos.get_pos());
+            }
+        }
+
+        Node* first = other.head;
+        Node* last = other.tail;
+        size_type count = other.size_;
+        other.head = nullptr;
+        other.tail = nullptr;
+        other.size_ = 0;
+
+        Node* prev_node = next_node ? next_node->prev : tail;
+
+        first->prev = prev_node;
+        last->next = next_node;
+        if (prev_node) prev_node->next = first; else head = first;
+        if (next_node) next_node->prev = last; else tail = last;
+        size_ += count;
+    }
+
+    void splice(const_iterator pos, unrolled_list&& other) {
+        splice(pos, other);
+    }
+
+    // Private chain of nodes that one thread fills without synchronization
+    // and then hands over to a shared list in one splice. Nodes are allocated
+    // with the target's allocator, so committing never copies an element.
+    class staging_buffer {
+    private:
+        unrolled_list chain;
+
+    public:
+        explicit staging_buffer(const Allocator& alloc = Allocator()) : chain(alloc) {}
+
+        void push_back(const T& value) {
+            chain.emplace_back(value);
+        }
+
+        void push_back(T&& value) {
+            chain.emplace_back(std::move(value));
+        }
+
+        template<typename... Args>
+        reference emplace_back(Args&&... args) {
+            return chain.emplace_back(std::forward<Args>(args)...);
+        }
+
+        size_type size() const noexcept {
+            return chain.size();
+        }
+
+        bool empty() const noexcept {
+            return chain.empty();
+        }
+
+        void clear() noexcept {
+            chain.clear();
+        }
+
+        // Append everything staged to target, the caller synchronizes access to target
+        void commit(unrolled_list& target) {
+            target.splice(target.end(), chain);
+        }
+
+        // Append everything staged to target while holding lock for just the splice
+        template<typename Lockable>
+        void commit(unrolled_list& target, Lockable& lock) {
+            std::lock_guard<Lockable> guard(lock);
+            target.splice(target.end(), chain);
+        }
+    };
+
+    staging_buffer make_staging_buffer() const {
+        return staging_buffer(allocator);
+    }
+
+    // Removal with compaction, returning the number of removed elements.
+    // Elements are moved into the gaps, so their move constructor must not
+    // throw; a throwing predicate stops the removal and leaves the rest in place.
+    template<typename Pred>
+    size_type erase_if(Pred pred) requires std::is_nothrow_move_constructible_v<T> {
+        return compact([&pred](const T*, const T& value) { return pred(value); });
+    }
+
+    size_type remove(const T& value) requires std::is_nothrow_move_constructible_v<T> {
+        const T target = value; // value may refer to an element of this list
+        return erase_if([&target](const T& item) { return item == target; });
+    }
+
+    size_type unique() requires std::is_nothrow_move_constructible_v<T> {
+        return unique(std::equal_to<T>());
+    }
+
+    template<typename BinaryPredicate>
+    size_type unique(BinaryPredicate pred) requires std::is_nothrow_move_constructible_v<T> {
+        return compact([&pred](const T* last_kept, const T& value) {
+            return last_kept && pred(*last_kept, value);
+        });
+    }
+
+    // Node-level list operations
+    void reverse() noexcept(std::is_nothrow_swappable_v<T>) {
+        for (Node* node = head; node; node = node->prev) { // prev is the old next after the swap
+            std::swap(node->next, node->prev);
+            std::reverse(node->data, node->data + node->size);
+            touch(node);
+        }
+        std::swap(head, tail);
+    }
+
+    // Make pos the first element. Only the node containing pos is split, the
+    // rest is relinked. Returns the new position of the old first element.
+    iterator rotate(const_iterator pos) {
+        if (pos == begin()) return end();
+        if (pos == end()) return begin();
+
+        Node* node = pos.get_node();
+        if (pos.get_pos() > 0) {
+            node = split_node(node, pos.get_pos());
+        }
+
+        Node* old_head = head;
+        Node* last = node->prev;
+        last->next = nullptr;
+        node->prev = nullptr;
+        tail->next = old_head;
+        old_head->prev = tail;
+        head = node;
+        tail = last;
+        return iterator(old_head, 0);
+    }
+
+    // Merge the sorted other into this sorted list. The merge is stable, the
+    // output is packed into full nodes taken from the drained source nodes and
+    // the tail of whichever list outlasts the other is relinked untouched.
+    // Allocators must compare equal and comp must not throw.
+    void merge(unrolled_list& other) requires std::is_nothrow_move_constructible_v<T> {
+        merge(other, std::less<T>());
+    }
+
+    void merge(unrolled_list&& other) requires std::is_nothrow_move_constructible_v<T> {
+        merge(other, std::less<T>());
+    }
+
+    template<typename Compare>
+    void merge(unrolled_list&& other, Compare comp) requires std::is_nothrow_move_constructible_v<T> {
+        merge(other, comp);
+    }
+
+    template<typename Compare>
+    void merge(unrolled_list& other, Compare comp) requires std::is_nothrow_move_constructible_v<T> {
+        if (this == &other || other.empty()) return;
+
+        auto adopt_other = [&]() {
+            other.head = nullptr;
+            other.tail = nullptr;
+            size_ += other.size_;
+            other.size_ = 0;
+        };
+
+        if (empty()) {
+            clear();
+            head = other.head;
+            tail = other.tail;
+            if constexpr (Instrumentation::enabled) instrumentation_.lists_merged(0);
+            adopt_other();
+            return;
+        }
+        // Const access, peeking at the ends is not a modification for checkpoints
+        if (!comp(std::as_const(other).front(), std::as_const(*this).back())) { // Already ordered, append the chain
+            tail->next = other.head;
+            other.head->prev = tail;
+            tail = other.tail;
+            if constexpr (Instrumentation::enabled) instrumentation_.lists_merged(0);
+            adopt_other();
+            return;
+        }
+        if (comp(std::as_const(other).back(), std::as_const(*this).front())) { // Already ordered, prepend the chain
+            other.tail->next = head;
+            head->prev = other.tail;
+            head = other.head;
+            if constexpr (Instrumentation::enabled) instrumentation_.lists_merged(0);
+            adopt_other();
+            return;
+        }
+
+        // Two spare nodes are always enough: drained source nodes are recycled
+        // before the output can outgrow them
+        Node* free_nodes = allocate_node();
+        try {
+            free_nodes->next = allocate_node();
+        } catch (...) {
+            free_node(free_nodes);
+            throw;
+        }
+
+        Node* out_head = nullptr;
+        Node* out_tail = nullptr;
+
+        auto skip_drained = [&](Node*& node, size_t& pos) {
+            while (node && pos == node->size) {
+                Node* next = node->next;
+                node->size = 0;
+                node->next = free_nodes;
+                free_nodes = node;
+                node = next;
+                pos = 0;
+            }
+        };
+
+        auto take = [&](Node*& node, size_t& pos) {
+            if (!out_tail || out_tail->is_full()) {
+                Node* out = free_nodes;
+                free_nodes = out->next;
+                out->prev = out_tail;
+                out->next = nullptr;
+                if (out_tail) {
+                    out_tail->next = out;
+                } else {
+                    out_head = out;
+                }
+                out_tail = out;
+                touch(out);
+            }
+            out_tail->emplace_back(std::move(node->data[pos]));
+            std::allocator_traits<Allocator>::destroy(allocator, node->data + pos);
+            ++pos;
+            skip_drained(node, pos);
+        };
+
+        Node* a = head;
+        Node* b = other.head;
+        size_t a_pos = 0;
+        size_t b_pos = 0;
+        skip_drained(a, a_pos);
+        skip_drained(b, b_pos);
+
+        while (a && b) {
+            if (comp(b->data[b_pos], a->data[a_pos])) {
+                take(b, b_pos);
+            } else {
+                take(a, a_pos);
+            }
+        }
+
+        // Finish the partially consumed node of the remaining side, then relink its tail
+        Node* rest_tail = a ? tail : other.tail;
+        Node*& rest = a ? a : b;
+        size_t& rest_pos = a ? a_pos : b_pos;
+        if (rest && rest_pos > 0) {
+            Node* partial = rest;
+            while (rest == partial) {
+                take(rest, rest_pos);
+            }
+        }
+        if constexpr (Instrumentation::enabled) { // Everything in the output chain so far was moved
+            size_t moved = 0;
+            for (Node* node = out_head; node; node = node->next) moved += node->size;
+            instrumentation_.lists_merged(moved);
+        }
+        if (rest) {
+            rest->prev = out_tail;
+            out_tail->next = rest;
+            out_tail = rest_tail;
+        }
+
+        while (free_nodes) {
+            Node* next = free_nodes->next;
+            free_node(free_nodes);
+            free_nodes = next;
+        }
+
+        head = out_head;
+        tail = out_tail;
+        adopt_other();
+    }
+
+    // Sorting
+    // LSD radix sort, 8 bits per pass. Every key is computed once, before
+    // anything is moved, and kept next to its element, so a throwing key
+    // function leaves the list unchanged. Passes over digits shared by all keys
+    // are skipped, and the result is a freshly packed chain with every node full
+    // except possibly the last one.
+    void radix_sort() requires radix_sort_key<T> {
+        radix_sort(std::identity{});
+    }
+
+    template<typename KeyFn>
+        requires radix_sort_key<std::remove_cvref_t<std::invoke_result_t<KeyFn&, const T&>>> &&
+                 std::is_nothrow_move_constructible_v<T>
+    void radix_sort(KeyFn key) {
+        using Key = std::remove_cvref_t<std::invoke_result_t<KeyFn&, const T&>>;
+        using Bits = decltype(radix_key_bits(Key()));
+        constexpr size_t passes = sizeof(Key);
+        using Counts = std::array<size_t, 256>;
+
+        if (size_ < 2) return;
+
+        auto digit = [](Bits bits, size_t pass) {
+            return static_cast<size_t>((bits >> (8 * pass)) & 0xFF);
+        };
+
+        // Keys in chain order and histograms of every digit in a single pass over the node blocks
+        std::vector<Bits> keys;
+        keys.reserve(size_);
+        std::array<Counts, passes> counts{};
+        for (Node* node = head; node; node = node->next) {
+            for (size_t i = 0; i < node->size; ++i) {
+                Bits bits = radix_key_bits(static_cast<Key>(std::invoke(key, std::as_const(node->data[i]))));
+                keys.push_back(bits);
+                for (size_t pass = 0; pass < passes; ++pass) {
+                    ++counts[pass][digit(bits, pass)];
+                }
+            }
+        }
+
+        std::vector<size_t> active_passes;
+        for (size_t pass = 0; pass < passes; ++pass) {
+            if (std::find(counts[pass].begin(), counts[pass].end(), size_) == counts[pass].end()) {
+                active_passes.push_back(pass);
+            }
+        }
+        if (active_passes.empty()) active_passes.push_back(0); // Still repack the nodes
+
+        // All allocations happen before any element is moved
+        const size_t node_count = (size_ + NodeMaxSize - 1) / NodeMaxSize;
+        std::vector<Node*> from = allocate_chain(node_count);
+        std::vector<Node*> to;
+        std::vector<Bits> sorted_keys; // Keys in the order of the chain being filled
+        try {
+            to.reserve(node_count);
+            if (active_passes.size() > 1) sorted_keys.resize(size_);
+        } catch (...) {
+            for (Node* node : from) free_node(node);
+            throw;
+        }
+
+        // Move every element of the chain starting at first into its bucket slot of target
+        auto scatter = [&](Node* first, const std::vector<Node*>& target, size_t pass) {
+            Counts offsets;
+            size_t sum = 0;
+            for (size_t b = 0; b < offsets.size(); ++b) {
+                offsets[b] = sum;
+                sum += counts[pass][b];
+            }
+            size_t position = 0;
+            for (Node* node = first; node; node = node->next) {
+                for (size_t i = 0; i < node->size; ++i, ++position) {
+                    size_t index = offsets[digit(keys[position], pass)]++;
+                    if (!sorted_keys.empty()) sorted_keys[index] = keys[position];
+                    new (target[index / NodeMaxSize]->data + index % NodeMaxSize) T(std::move(node->data[i]));
+                    std::allocator_traits<Allocator>::destroy(allocator, node->data + i);
+                }
+                node->size = 0;
+            }
+            for (Node* node : target) {
+                node->size = NodeMaxSize;
+                touch(node);
+            }
+            target.back()->size = size_ - (target.size() - 1) * NodeMaxSize;
+            keys.swap(sorted_keys);
+        };
+
+        scatter(head, from, active_passes[0]);
+
+        // The emptied original nodes become the second buffer, the surplus is released
+        Node* node = head;
+        while (node) {
+            Node* next = node->next;
+            if (to.size() < node_count && active_passes.size() > 1) {
+                to.push_back(node);
+            } else {
+                free_node(node);
+            }
+            node = next;
+        }
+        if (!to.empty()) to.back()->next = nullptr;
+
+        for (size_t k = 1; k < active_passes.size(); ++k) {
+            scatter(from.front(), to, active_passes[k]);
+            std::swap(from, to);
+        }
+        for (Node* spare : to) free_node(spare);
+
+        head = from.front();
+        tail = from.back();
+    }
+
+    // Serialization
+    // A 24-byte header followed by the elements. Trivially copyable types are
+    // written as raw node blocks in native byte order, one write per node;
+    // other types go through unrolled_list_serializer<T>.
+    void serialize(std::ostream& out) const
+        requires unrolled_list_block_serializable<T> || unrolled_list_custom_serializable<T> {
+        SerializedHeader header = serialized_header();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (Node* node = head; node; node = node->next) {
+            write_elements(out, node);
+        }
+        if (!out) throw std::runtime_error("unrolled_list: write failed");
+    }
+
+    // Reads a list written by serialize, filling full nodes straight from the stream
+    static unrolled_list deserialize(std::istream& in, const Allocator& alloc = Allocator())
+        requires unrolled_list_block_serializable<T> || unrolled_list_custom_serializable<T> {
+        SerializedHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            throw std::runtime_error("unrolled_list: missing header");
+        }
+        check_header(header);
+
+        unrolled_list result(alloc);
+        if constexpr (unrolled_list_block_serializable<T>) {
+            if (result.read_blocks(in, header.count) != header.count) {
+                throw std::runtime_error("unrolled_list: truncated input");
+            }
+        } else {
+            for (uint64_t i = 0; i < header.count; ++i) {
+                result.emplace_back(unrolled_list_serializer<T>::read(in));
+                if (!in) throw std::runtime_error("unrolled_list: truncated input");
+            }
+        }
+        return result;
+    }
+
+#ifdef UNROLLED_LIST_POSIX_IO
+    // Same format written with writev, one iovec per node
+    void serialize(int fd) const requires unrolled_list_block_serializable<T> {
+        SerializedHeader header = serialized_header();
+        std::vector<iovec> iov;
+        iov.push_back(iovec{&header, sizeof(header)});
+        for (Node* node = head; node; node = node->next) {
+            iov.push_back(iovec{node->data, node->size * sizeof(T)});
+        }
+        write_all(fd, iov.data(), iov.size());
+    }
+
+    static unrolled_list deserialize(int fd, const Allocator& alloc = Allocator())
+        requires unrolled_list_block_serializable<T> {
+        SerializedHeader header;
+        iovec iov{&header, sizeof(header)};
+        if (read_all(fd, &iov, 1) != sizeof(header)) {
+            throw std::runtime_error("unrolled_list: missing header");
+        }
+        check_header(header);
+
+        unrolled_list result(alloc);
+        if (result.read_blocks(fd, header.count) != header.count) {
+            throw std::runtime_error("unrolled_list: truncated input");
+        }
+        return result;
+    }
+#endif
+
+    // Checkpoints, with unrolled_list_checkpoints as the Checkpointing policy
+    // Appends a record to out with only the nodes modified since the last
+    // checkpoint of this list and the runs of unchanged nodes around them.
+    // The first record, and the first after reset_checkpoint(), holds every
+    // node. Elements modified through iterators must be reported with
+    // mark_dirty(), non-const front(), back() and operator[] count as writes.
+    void checkpoint(std::ostream& out) requires Checkpointing::enabled &&
+        (unrolled_list_block_serializable<T> || unrolled_list_custom_serializable<T>) {
+        std::unordered_map<uint64_t, uint64_t> base;
+        base.reserve(checkpoint_.ids.size());
+        for (size_t i = 0; i < checkpoint_.ids.size(); ++i) {
+            base.emplace(checkpoint_.ids[i], i);
+        }
+
+        std::vector<uint64_t> ids;
+        std::vector<CheckpointRun> runs;
+        std::vector<const Node*> payload;
+        for (const Node* node = head; node; node = node->next) {
+            ids.push_back(node->checkpoint.id);
+            uint64_t index = NewNodes;
+            if (node->checkpoint.generation <= checkpoint_.generation) {
+                auto kept = base.find(node->checkpoint.id);
+                if (kept != base.end()) index = kept->second;
+            }
+            if (index == NewNodes) payload.push_back(node);
+
+            bool extends = !runs.empty() && (index == NewNodes
+                ? runs.back().base == NewNodes
+                : runs.back().base != NewNodes && runs.back().base + runs.back().length == index);
+            if (extends) {
+                ++runs.back().length;
+            } else {
+                runs.push_back(CheckpointRun{index, 1});
+            }
+        }
+
+        SerializedHeader format = serialized_header();
+        CheckpointHeader header{CheckpointMagic, SerializedVersion, format.format, format.element_size,
+                                uint32_t(NodeMaxSize), uint64_t(size_), uint64_t(runs.size()),
+                                uint64_t(payload.size())};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(runs.data()), std::streamsize(runs.size() * sizeof(CheckpointRun)));
+        for (const Node* node : payload) {
+            uint64_t count = node->size;
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            write_elements(out, node);
+        }
+        if (!out) throw std::runtime_error("unrolled_list: write failed");
+
+        checkpoint_.ids = std::move(ids);
+        checkpoint_.generation = checkpoint_clock.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The next checkpoint writes every node, e.g. to start a new checkpoint file
+    void reset_checkpoint() noexcept requires Checkpointing::enabled {
+        checkpoint_.ids.clear();
+        checkpoint_.ids.shrink_to_fit();
+    }
+
+    // Report a write through an iterator to the node containing pos
+    void mark_dirty(const_iterator pos) noexcept requires Checkpointing::enabled {
+        if (pos.get_node()) touch(pos.get_node());
+    }
+
+    // Replays the records of in up to its end and returns the list as of the
+    // last one. Further checkpoints of the result continue the same chain.
+    static unrolled_list restore(std::istream& in, const Allocator& alloc = Allocator()) requires Checkpointing::enabled &&
+        (unrolled_list_block_serializable<T> || unrolled_list_custom_serializable<T>) {
+        unrolled_list result(alloc);
+        std::vector<Node*> image; // Unlinked nodes of the last record
+        std::vector<Node*> next;
+        auto release = [&result](std::vector<Node*>& nodes) {
+            for (Node* node : nodes) {
+                if (node) result.free_node(node);
+            }
+            nodes.clear();
+        };
+
+        try {
+            while (in.peek() != std::char_traits<char>::eof()) {
+                CheckpointHeader header;
+                if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+                    throw std::runtime_error("unrolled_list: truncated checkpoint");
+                }
+                bool blocks = unrolled_list_block_serializable<T>;
+                if (header.magic != CheckpointMagic || header.version != SerializedVersion) {
+                    throw std::runtime_error("unrolled_list: not an unrolled_list checkpoint");
+                }
+                if (header.format != (blocks ? SerializedBlocks : SerializedCustom) ||
+                    (blocks && header.element_size != sizeof(T)) || header.node_max_size != NodeMaxSize) {
+                    throw std::runtime_error("unrolled_list: checkpoint element type does not match");
+                }
+
+                std::vector<CheckpointRun> runs(header.run_count);
+                if (!in.read(reinterpret_cast<char*>(runs.data()), std::streamsize(runs.size() * sizeof(CheckpointRun)))) {
+                    throw std::runtime_error("unrolled_list: truncated checkpoint");
+                }
+
+                uint64_t payload_left = header.payload_count;
+                uint64_t count = 0;
+                for (const CheckpointRun& run : runs) {
+                    for (uint64_t i = 0; i < run.length; ++i) {
+                        Node* node;
+                        if (run.base == NewNodes) {
+                            uint64_t size;
+                            if (payload_left-- == 0 || !in.read(reinterpret_cast<char*>(&size), sizeof(size)) ||
+                                size == 0 || size > NodeMaxSize) {
+                                throw std::runtime_error("unrolled_list: corrupt checkpoint");
+                            }
+                            node = result.allocate_node();
+                            next.push_back(node);
+                            read_elements(in, node, size);
+                        } else {
+                            if (run.base + i >= image.size() || !image[run.base + i]) {
+                                throw std::runtime_error("unrolled_list: corrupt checkpoint");
+                            }
+                            node = std::exchange(image[run.base + i], nullptr);
+                            next.push_back(node);
+                        }
+                        count += node->size;
+                    }
+                }
+                if (payload_left != 0 || count != header.count) {
+                    throw std::runtime_error("unrolled_list: corrupt checkpoint");
+                }
+                release(image);
+                std::swap(image, next);
+            }
+        } catch (...) {
+            release(image);
+            release(next);
+            throw;
+        }
+
+        // Link the last image and make it the base of further checkpoints
+        for (Node* node : image) {
+            node->next = nullptr;
+            node->prev = result.tail;
+            if (result.tail) result.tail->next = node; else result.head = node;
+            result.tail = node;
+            result.size_ += node->size;
+            result.checkpoint_.ids.push_back(node->checkpoint.id);
+        }
+        result.checkpoint_.generation = checkpoint_clock.fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+
+    // Loading raw elements
+    // Reads trivially copyable elements in native layout until end of input,
+    // straight into freshly created full nodes without an intermediate buffer
+    static unrolled_list from_stream(std::istream& in, const Allocator& alloc = Allocator())
+        requires unrolled_list_block_serializable<T> {
+        unrolled_list result(alloc);
+        result.read_blocks(in, std::numeric_limits<size_t>::max());
+        return result;
+    }
+
+#ifdef UNROLLED_LIST_POSIX_IO
+    // Same from a file descriptor, filling a batch of nodes with each readv.
+    // For regular files read_ahead enables sequential read-ahead and asks the
+    // kernel to fetch the next batch while the current one is copied.
+    static unrolled_list from_fd(int fd, bool read_ahead = true, const Allocator& alloc = Allocator())
+        requires unrolled_list_block_serializable<T> {
+#ifdef POSIX_FADV_SEQUENTIAL
+        if (read_ahead) ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        unrolled_list result(alloc);
+        result.read_blocks(fd, std::numeric_limits<size_t>::max(), read_ahead);
+        return result;
+    }
+#endif
 };
 
 // Comparison oparetors
-template<typename T, size_t N, typename A>
-bool operator==(const unrolled_list<T, N, A>& lhs, const unrolled_list<T, N, A>& rhs) {
+template<typename T, size_t N, typename A, typename I, typename C>
+bool operator==(const unrolled_list<T, N, A, I, C>& lhs, const unrolled_list<T, N, A, I, C>& rhs) {
     if (lhs.size() != rhs.size()) return false;
     return std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template<typename T, size_t N, typename A>
-bool operator!=(const unrolled_list<T, N, A>& lhs, const unrolled_list<T, N, A>& rhs) {
+template<typename T, size_t N, typename A, typename I, typename C>
+bool operator!=(const unrolled_list<T, N, A, I, C>& lhs, const unrolled_list<T, N, A, I, C>& rhs) {
     return !(lhs == rhs);
-}
\ No newline at end of file
+}
+
+template<typename T, size_t N, typename A, typename I, typename C, typename Pred>
+typename unrolled_list<T, N, A, I, C>::size_type erase_if(unrolled_list<T, N, A, I, C>& list, Pred pred) {
+    return list.erase_if(pred);
+}
+
+template<typename T, size_t N, typename A, typename I, typename C, typename U>
+typename unrolled_list<T, N, A, I, C>::size_type erase(unrolled_list<T, N, A, I, C>& list, const U& value) {
+    const U target = value; // value may refer to an element of list
+    return list.erase_if([&target](const T& item) { return item == target; });
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+// Node and position of the element at index in a chain of nodes linked from
+// head, shared by the lists that keep only a head, a tail and a total size.
+// Node addresses a node, e.g. a pointer or an offset into a file, and its
+// value-initialized Node{} means none. size_of and next_of read a node's
+// header. Positions in the tail node, appends included, are found without
+// walking the chain, and index == total maps to the end of the tail.
+template<typename Node, typename SizeOf, typename NextOf>
+std::pair<Node, size_t> unrolled_list_locate(Node head, Node tail, size_t total, size_t index,
+                                             SizeOf size_of, NextOf next_of) {
+    if (tail != Node{}) {
+        size_t before_tail = total - size_of(tail);
+        if (index >= before_tail) return {tail, index - before_tail};
+    }
+    Node node = head;
+    while (node != Node{} && index >= size_of(node)) {
+        index -= size_of(node);
+        node = next_of(node);
+    }
+    return {node, index};
+}
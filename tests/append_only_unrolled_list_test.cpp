@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <append_only_unrolled_list.h>
+
+namespace {
+
+// Throws from the constructor on request
+struct fragile {
+    int value;
+
+    explicit fragile(int value, bool fail = false) : value(value) {
+        if (fail) throw std::runtime_error("fragile");
+    }
+};
+
+} // namespace
+
+TEST(AppendOnlyUnrolledList, AppendAndIterate) {
+    append_only_unrolled_list<std::string, 4> list;
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.size(), 0u);
+    const std::string& first = list.emplace_back("a");
+    for (int i = 0; i < 20; ++i) list.push_back(std::to_string(i));
+    EXPECT_EQ(&first, &*list.begin()); // References stay valid as nodes are added
+    EXPECT_EQ(list.size(), 21u);
+    std::vector<std::string> values(list.begin(), list.end());
+    ASSERT_EQ(values.size(), 21u);
+    EXPECT_EQ(values[0], "a");
+    for (int i = 0; i < 20; ++i) EXPECT_EQ(values[i + 1], std::to_string(i));
+}
+
+TEST(AppendOnlyUnrolledList, ThrowingConstructorLeavesNoGap) {
+    append_only_unrolled_list<fragile, 4> list;
+    list.emplace_back(0);
+    list.emplace_back(1);
+    EXPECT_THROW(list.emplace_back(2, true), std::runtime_error);
+    list.emplace_back(3);
+    list.emplace_back(4);
+    std::vector<int> values;
+    for (const fragile& item : list) values.push_back(item.value);
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 3, 4}));
+    EXPECT_EQ(list.size(), 4u);
+}
+
+// Readers iterate while appenders run; every snapshot must be a consistent
+// prefix in which each appender's values appear in order
+TEST(AppendOnlyUnrolledList, ConcurrentAppendersAndReaders) {
+    constexpr int Appenders = 4;
+    constexpr int PerAppender = 20000;
+    append_only_unrolled_list<int, 32> list;
+    std::atomic<int> done{0};
+    std::atomic<bool> inconsistent{false};
+
+    std::vector<std::thread> threads;
+    for (int a = 0; a < Appenders; ++a) {
+        threads.emplace_back([&, a] {
+            for (int i = 0; i < PerAppender; ++i) list.push_back(a * PerAppender + i);
+            ++done;
+        });
+    }
+    threads.emplace_back([&] {
+        size_t last_count = 0;
+        while (done.load() < Appenders) {
+            std::vector<int> last(Appenders, -1);
+            size_t count = 0;
+            for (int value : list) {
+                int appender = value / PerAppender;
+                if (value <= last[appender]) inconsistent = true;
+                last[appender] = value;
+                ++count;
+            }
+            if (count < last_count) inconsistent = true; // The published prefix only grows
+            last_count = count;
+        }
+    });
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_FALSE(inconsistent);
+    std::vector<int> values(list.begin(), list.end());
+    ASSERT_EQ(values.size(), size_t(Appenders * PerAppender));
+    EXPECT_EQ(list.size(), values.size());
+    std::sort(values.begin(), values.end());
+    for (int i = 0; i < Appenders * PerAppender; ++i) ASSERT_EQ(values[i], i);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unrolled_list.h>
+
+namespace {
+
+using list = unrolled_list<uint64_t, 8, std::allocator<uint64_t>, unrolled_list_no_instrumentation,
+                           unrolled_list_checkpoints>;
+
+// Record sizes: header, runs of base index and length, then a size and the elements per written node
+constexpr size_t HeaderBytes = 40;
+constexpr size_t RunBytes = 16;
+
+constexpr size_t record_bytes(size_t runs, size_t nodes, size_t elements) {
+    return HeaderBytes + runs * RunBytes + nodes * sizeof(uint64_t) + elements * sizeof(uint64_t);
+}
+
+list iota(uint64_t count) {
+    list result;
+    for (uint64_t i = 0; i < count; ++i) result.push_back(i);
+    return result;
+}
+
+// Appends a checkpoint of list to records and returns its size
+size_t append_checkpoint(list& list, std::stringstream& records) {
+    size_t before = records.str().size();
+    list.checkpoint(records);
+    return records.str().size() - before;
+}
+
+list restore(const std::stringstream& records) {
+    std::istringstream in(records.str());
+    return list::restore(in);
+}
+
+template<typename List>
+concept checkpointable = requires(List& list, std::ostream& out) { list.checkpoint(out); };
+
+static_assert(checkpointable<list>);
+static_assert(!checkpointable<unrolled_list<uint64_t, 8>>, "checkpoints are opt-in");
+
+} // namespace
+
+TEST(Checkpoint, BaseAndDeltas) {
+    list values = iota(100); // 12 full nodes and a tail of 4
+    std::stringstream records;
+    EXPECT_EQ(append_checkpoint(values, records), record_bytes(1, 13, 100));
+
+    values[20] = 1000; // Third node
+    EXPECT_EQ(append_checkpoint(values, records), record_bytes(3, 1, 8));
+
+    values.push_back(100); // Tail only
+    EXPECT_EQ(append_checkpoint(values, records), record_bytes(2, 1, 5));
+
+    EXPECT_EQ(append_checkpoint(values, records), record_bytes(1, 0, 0)); // Nothing changed
+
+    auto it = std::next(values.begin(), 50);
+    *it = 7;
+    values.mark_dirty(it);
+    values.erase(values.begin()); // Shifts the first node
+    EXPECT_EQ(append_checkpoint(values, records), record_bytes(4, 2, 15));
+
+    list restored = restore(records);
+    EXPECT_EQ(restored, values);
+    EXPECT_EQ(restored[19], 1000u);
+    EXPECT_EQ(restored.back(), 100u);
+}
+
+TEST(Checkpoint, ReadsAndOrderedMergesWriteNothing) {
+    list values = iota(16); // Two full nodes
+    std::stringstream records;
+    append_checkpoint(values, records);
+
+    const list& view = values;
+    uint64_t sum = 0;
+    for (uint64_t value : view) sum += value;
+    sum += view.front() + view.back() + view[9];
+    EXPECT_EQ(sum, 120u + 0 + 15 + 9);
+    EXPECT_EQ(append_checkpoint(values, records), record_bytes(1, 0, 0));
+
+    list larger;
+    for (uint64_t i = 100; i < 108; ++i) larger.push_back(i);
+    values.merge(larger); // Appends the chain, the nodes of values stay as they are
+    EXPECT_EQ(append_checkpoint(values, records), record_bytes(2, 1, 8));
+    EXPECT_EQ(restore(records), values);
+}
+
+TEST(Checkpoint, CheckpointsAfterRestoreContinueTheChain) {
+    list values = iota(40);
+    std::stringstream records;
+    append_checkpoint(values, records);
+    values[3] = 300;
+    append_checkpoint(values, records);
+
+    list restored = restore(records);
+    EXPECT_EQ(restored, values);
+    restored[35] = 3500; // Last node
+    EXPECT_EQ(append_checkpoint(restored, records), record_bytes(2, 1, 8));
+
+    list moved = std::move(restored); // The chain moves with the nodes
+    moved.push_front(9); // The head is full, a new node goes in front of it
+    EXPECT_EQ(append_checkpoint(moved, records), record_bytes(2, 1, 1));
+
+    list latest = restore(records);
+    EXPECT_EQ(latest, moved);
+    EXPECT_EQ(latest.front(), 9u);
+    EXPECT_EQ(latest[36], 3500u);
+
+    moved.reset_checkpoint(); // Starts a new file
+    std::stringstream fresh;
+    EXPECT_EQ(append_checkpoint(moved, fresh), record_bytes(1, 6, 41));
+    EXPECT_EQ(restore(fresh), moved);
+}
+
+TEST(Checkpoint, RejectsTruncatedAndForeignRecords) {
+    list values = iota(20);
+    std::stringstream records;
+    append_checkpoint(values, records);
+    std::string bytes = records.str();
+
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 8));
+    EXPECT_THROW(list::restore(truncated), std::runtime_error);
+
+    std::ostringstream serialized;
+    values.serialize(serialized);
+    std::istringstream foreign(serialized.str());
+    EXPECT_THROW(list::restore(foreign), std::runtime_error);
+
+    std::istringstream empty;
+    EXPECT_TRUE(list::restore(empty).empty());
+}
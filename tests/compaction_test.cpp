@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include <unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+} // namespace
+
+TEST(Compaction, EraseIfPacksSurvivors) {
+    unrolled_list<int, 4> list;
+    for (int i = 0; i < 40; ++i) list.push_back(i);
+    EXPECT_EQ(list.erase_if([](int value) { return value % 3 != 0; }), 26u);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39}));
+    EXPECT_EQ(list.size(), 14u);
+    EXPECT_EQ(list.stats().node_count, 4u);
+    EXPECT_EQ(list.back(), 39);
+}
+
+TEST(Compaction, EraseEverything) {
+    unrolled_list<int, 4> list = {1, 2, 3, 4, 5, 6};
+    EXPECT_EQ(list.erase_if([](int) { return true; }), 6u);
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.begin(), list.end());
+    list.push_back(7);
+    EXPECT_EQ(to_vector(list), std::vector<int>{7});
+}
+
+TEST(Compaction, RemoveValueFromTheList) {
+    unrolled_list<int, 3> list = {2, 1, 2, 2, 3, 2, 4};
+    EXPECT_EQ(list.remove(list.front()), 4u); // The argument refers to an element that is removed
+    EXPECT_EQ(to_vector(list), (std::vector<int>{1, 3, 4}));
+}
+
+TEST(Compaction, FreeEraseWithValueFromTheList) {
+    unrolled_list<int, 3> list = {2, 1, 2, 2, 3, 2, 4};
+    EXPECT_EQ(erase(list, list.front()), 4u);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{1, 3, 4}));
+}
+
+TEST(Compaction, Unique) {
+    unrolled_list<int, 3> list = {1, 1, 2, 2, 2, 3, 1, 1, 4, 4};
+    EXPECT_EQ(list.unique(), 5u);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{1, 2, 3, 1, 4}));
+
+    unrolled_list<int, 3> close = {1, 2, 4, 5, 9, 10, 11};
+    close.unique([](int kept, int value) { return value - kept == 1; });
+    EXPECT_EQ(to_vector(close), (std::vector<int>{1, 4, 9, 11}));
+}
+
+TEST(Compaction, ThrowingPredicateKeepsTheRest) {
+    unrolled_list<int, 4> list;
+    for (int i = 0; i < 20; ++i) list.push_back(i);
+    EXPECT_THROW(list.erase_if([](int value) {
+        if (value == 10) throw std::runtime_error("pred");
+        return value % 2 == 0;
+    }), std::runtime_error);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{1, 3, 5, 7, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19}));
+    EXPECT_EQ(list.size(), 15u);
+    list.push_back(20);
+    EXPECT_EQ(list.back(), 20);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <compressed_unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+} // namespace
+
+TEST(CompressedUnrolledList, MatchesVectorWithFewHotNodes) {
+    compressed_unrolled_list<int32_t, 16> list(2);
+    std::vector<int32_t> expected;
+    std::mt19937 random(11);
+    for (int32_t i = 0; i < 4000; ++i) {
+        size_t pos = expected.empty() ? 0 : random() % (expected.size() + 1);
+        int32_t value = random() % 4 == 0 ? int32_t(random()) : i; // Mostly increasing, some wide deltas
+        switch (random() % 4) {
+            case 0:
+            case 1:
+                list.push_back(value);
+                expected.push_back(value);
+                break;
+            case 2:
+                list.insert(pos, value);
+                expected.insert(expected.begin() + pos, value);
+                break;
+            default:
+                if (pos < expected.size()) {
+                    list.erase(pos);
+                    expected.erase(expected.begin() + pos);
+                }
+        }
+        EXPECT_LE(list.hot_nodes(), 2u);
+    }
+    EXPECT_EQ(to_vector(list), expected);
+    for (size_t i = 0; i < expected.size(); i += 7) EXPECT_EQ(list[i], expected[i]);
+    list.set(3, -5);
+    expected[3] = -5;
+    list.compress_all();
+    EXPECT_EQ(list.hot_nodes(), 0u);
+    EXPECT_EQ(to_vector(list), expected);
+    EXPECT_EQ(list.front(), expected.front());
+    EXPECT_EQ(list.back(), expected.back());
+    EXPECT_THROW(list.at(expected.size()), std::out_of_range);
+}
+
+TEST(CompressedUnrolledList, AppendsFillNodes) {
+    compressed_unrolled_list<uint64_t, 64> list(4);
+    for (uint64_t i = 0; i < 6400; ++i) list.push_back(1000 + 3 * i);
+
+    size_t blocks = 0;
+    uint64_t expected = 1000;
+    list.for_each_block([&](std::span<const uint64_t> block) {
+        ++blocks;
+        EXPECT_EQ(block.size(), 64u);
+        for (uint64_t value : block) {
+            EXPECT_EQ(value, expected);
+            expected += 3;
+        }
+    });
+    EXPECT_EQ(blocks, 100u);
+    // Four hot blocks, the rest packed with zero bit deltas: header and padding only
+    EXPECT_EQ(list.memory_usage(), 4 * 64 * sizeof(uint64_t) + 96 * (2 * sizeof(uint64_t) + 1 + 8));
+}
+
+TEST(CompressedUnrolledList, ExtremeValuesStayPlain) {
+    using limits = std::numeric_limits<int64_t>;
+    compressed_unrolled_list<int64_t, 8> list(1);
+    std::vector<int64_t> expected = {limits::min(), limits::max(), 0, limits::min(), -1, 1, limits::max(), 0};
+    for (int64_t value : expected) list.push_back(value);
+    list.push_back(7); // Moves the hot node on, the full one cannot be packed
+    expected.push_back(7);
+    list.compress_all();
+    EXPECT_EQ(to_vector(list), expected);
+    EXPECT_EQ(list[1], limits::max());
+}
+
+TEST(CompressedUnrolledList, IteratorCopiesKeepTheirBlock) {
+    compressed_unrolled_list<uint16_t, 8> list;
+    for (uint16_t i = 0; i < 40; ++i) list.push_back(uint16_t(i * 2));
+    list.compress_all();
+
+    auto it = list.begin();
+    auto copy = it;
+    for (int i = 0; i < 12; ++i) ++it; // Decodes the next node while copy still reads the first
+    EXPECT_EQ(*copy, 0);
+    EXPECT_EQ(*it, 24);
+    EXPECT_EQ(*++copy, 2);
+    EXPECT_EQ(std::distance(list.begin(), list.end()), 40);
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <concurrent_unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<int> to_vector(const List& list) {
+    std::vector<int> values;
+    list.for_each([&values](int value) { values.push_back(value); });
+    return values;
+}
+
+constexpr int Threads = 4;
+
+// Counts live objects to check that no slot is destroyed twice
+struct tracked {
+    static inline int live = 0;
+    int value;
+
+    explicit tracked(int value) : value(value) { ++live; }
+    tracked(const tracked& other) : value(other.value) { ++live; }
+    tracked(tracked&& other) noexcept : value(other.value) { ++live; }
+    ~tracked() { --live; }
+};
+
+} // namespace
+
+TEST(ConcurrentUnrolledList, SingleThreadedOperations) {
+    concurrent_unrolled_list<int, 4> list;
+    for (int i = 0; i < 10; ++i) list.push_back(i);
+    list.push_front(-1);
+    list.insert(5, 100);
+    list.insert(1000, 200); // Past the end appends
+    EXPECT_EQ(to_vector(list), (std::vector<int>{-1, 0, 1, 2, 3, 100, 4, 5, 6, 7, 8, 9, 200}));
+    EXPECT_EQ(list.size(), 13u);
+    EXPECT_EQ(list.get(5), 100);
+    EXPECT_FALSE(list.get(13).has_value());
+
+    EXPECT_EQ(list.extract(5), 100);
+    EXPECT_EQ(list.pop_front(), -1);
+    EXPECT_TRUE(list.erase(10));
+    EXPECT_FALSE(list.erase(10));
+    EXPECT_EQ(to_vector(list), (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    EXPECT_EQ(list.erase_if([](int value) { return value % 2 == 0; }), 5u);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{1, 3, 5, 7, 9}));
+    EXPECT_TRUE(list.contains(7));
+    EXPECT_FALSE(list.contains(8));
+    EXPECT_EQ(list.find_if([](int value) { return value > 4; }), 5);
+
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_FALSE(list.pop_front().has_value());
+    list.push_back(1);
+    EXPECT_EQ(to_vector(list), std::vector<int>{1});
+}
+
+TEST(ConcurrentUnrolledList, ThrowingPredicateKeepsTheRest) {
+    {
+        concurrent_unrolled_list<tracked, 4> list;
+        for (int i = 0; i < 12; ++i) list.emplace_back(i);
+        EXPECT_THROW(list.erase_if([](const tracked& element) {
+            if (element.value == 6) throw std::runtime_error("pred");
+            return element.value % 2 == 0;
+        }), std::runtime_error);
+        std::vector<int> values;
+        list.for_each([&values](const tracked& element) { values.push_back(element.value); });
+        EXPECT_EQ(values, (std::vector<int>{1, 3, 5, 6, 7, 8, 9, 10, 11}));
+        EXPECT_EQ(list.size(), 9u);
+        EXPECT_EQ(tracked::live, 9);
+        EXPECT_EQ(list.erase_if([](const tracked& element) { return element.value > 6; }), 5u);
+        EXPECT_EQ(list.size(), 4u);
+    }
+    EXPECT_EQ(tracked::live, 0);
+}
+
+TEST(ConcurrentUnrolledList, ConcurrentPushBackKeepsEachThreadsOrder) {
+    constexpr int PerThread = 5000;
+    concurrent_unrolled_list<int, 8> list;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&list, t] {
+            for (int i = 0; i < PerThread; ++i) list.push_back(t * PerThread + i);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    auto values = to_vector(list);
+    ASSERT_EQ(values.size(), size_t(Threads * PerThread));
+    EXPECT_EQ(list.size(), values.size());
+    std::vector<int> last(Threads, -1);
+    for (int value : values) {
+        int thread = value / PerThread;
+        EXPECT_LT(last[thread], value);
+        last[thread] = value;
+    }
+}
+
+TEST(ConcurrentUnrolledList, ConcurrentInsertEraseAndRead) {
+    constexpr int Initial = 2000;
+    constexpr int Ops = 4000;
+    concurrent_unrolled_list<int, 16> list;
+    for (int i = 0; i < Initial; ++i) list.push_back(i);
+
+    std::atomic<long> inserted{0};
+    std::atomic<long> erased{0};
+    std::atomic<bool> bad_read{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937 random(t + 1);
+            for (int i = 0; i < Ops; ++i) {
+                size_t index = random() % (Initial + 100);
+                switch (random() % 3) {
+                    case 0:
+                        list.insert(index, Initial + t * Ops + i);
+                        ++inserted;
+                        break;
+                    case 1:
+                        if (list.erase(index)) ++erased;
+                        break;
+                    default:
+                        if (auto value = list.get(index); value && (*value < 0 || *value >= Initial + Threads * Ops)) {
+                            bad_read = true;
+                        }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    EXPECT_FALSE(bad_read);
+    auto values = to_vector(list);
+    EXPECT_EQ(long(values.size()), Initial + inserted - erased);
+    EXPECT_EQ(list.size(), values.size());
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(std::adjacent_find(values.begin(), values.end()), values.end()); // Every value was inserted once
+}
+
+TEST(ConcurrentUnrolledList, ConcurrentDrain) {
+    constexpr int Total = 20000;
+    concurrent_unrolled_list<int, 8> list;
+    for (int i = 0; i < Total; ++i) list.push_back(i);
+
+    std::vector<std::vector<int>> taken(Threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&list, &taken, t] {
+            while (auto value = list.pop_front()) taken[t].push_back(*value);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    std::vector<int> all;
+    for (auto& part : taken) {
+        EXPECT_TRUE(std::is_sorted(part.begin(), part.end())); // Front pops come out in list order
+        all.insert(all.end(), part.begin(), part.end());
+    }
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(all.size(), size_t(Total));
+    for (int i = 0; i < Total; ++i) EXPECT_EQ(all[i], i);
+    EXPECT_TRUE(list.empty());
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <cow_unrolled_list.h>
+
+namespace {
+
+template<typename Range>
+auto to_vector(const Range& range) {
+    using value_type = std::decay_t<decltype(*range.begin())>;
+    return std::vector<value_type>(range.begin(), range.end());
+}
+
+// Counts allocations and their bytes of every rebound type together
+struct allocation_count {
+    static inline size_t value = 0;
+    static inline size_t bytes = 0;
+};
+
+template<typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        ++allocation_count::value;
+        allocation_count::bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const counting_allocator<U>&) const noexcept { return true; }
+};
+
+// Counts live objects to check that shared nodes are freed exactly once
+struct tracked {
+    static inline int live = 0;
+    int value;
+
+    explicit tracked(int value) : value(value) { ++live; }
+    tracked(const tracked& other) : value(other.value) { ++live; }
+    tracked(tracked&& other) noexcept : value(other.value) { ++live; }
+    tracked& operator=(const tracked&) = default;
+    ~tracked() { --live; }
+};
+
+} // namespace
+
+TEST(CowUnrolledList, MatchesVector) {
+    cow_unrolled_list<int, 4> list;
+    std::vector<int> expected;
+    std::mt19937 random(7);
+    for (int i = 0; i < 2000; ++i) {
+        size_t pos = expected.empty() ? 0 : random() % (expected.size() + 1);
+        switch (random() % 4) {
+            case 0:
+                list.push_back(i);
+                expected.push_back(i);
+                break;
+            case 1:
+                list.insert(pos, i);
+                expected.insert(expected.begin() + pos, i);
+                break;
+            case 2:
+                if (pos < expected.size()) {
+                    list.erase(pos);
+                    expected.erase(expected.begin() + pos);
+                }
+                break;
+            default:
+                if (pos < expected.size()) {
+                    list.assign(pos, -i);
+                    expected[pos] = -i;
+                }
+        }
+    }
+    EXPECT_EQ(to_vector(list), expected);
+    ASSERT_EQ(list.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) EXPECT_EQ(list[i], expected[i]);
+    EXPECT_EQ(list.front(), expected.front());
+    EXPECT_EQ(list.back(), expected.back());
+    EXPECT_THROW(list.at(expected.size()), std::out_of_range);
+}
+
+TEST(CowUnrolledList, SnapshotIsNotAffectedByMutation) {
+    cow_unrolled_list<std::string, 4> list;
+    for (int i = 0; i < 20; ++i) list.push_back(std::to_string(i));
+    auto before = list.snapshot();
+    auto values = to_vector(list);
+
+    list.assign(3, "x");
+    list.insert(10, "y");
+    list.erase(0);
+    list.pop_back();
+    list.push_front("z");
+    EXPECT_EQ(to_vector(before), values);
+    EXPECT_EQ(before.size(), 20u);
+    EXPECT_EQ(list.size(), 20u);
+    EXPECT_EQ(list[0], "z");
+    EXPECT_EQ(list[3], "x");
+
+    cow_unrolled_list<std::string, 4> copy = list;
+    copy.push_back("w");
+    EXPECT_EQ(list.size(), 20u);
+    EXPECT_EQ(copy.back(), "w");
+}
+
+TEST(CowUnrolledList, SnapshotsSurviveChunkSplits) {
+    cow_unrolled_list<int, 2> list;
+    std::vector<int> expected;
+    std::vector<std::pair<decltype(list.snapshot()), std::vector<int>>> snapshots;
+    std::mt19937 random(11);
+    for (int i = 0; i < 4000; ++i) {
+        size_t pos = expected.empty() ? 0 : random() % (expected.size() + 1);
+        if (random() % 3 == 0 && pos < expected.size()) {
+            list.erase(pos);
+            expected.erase(expected.begin() + pos);
+        } else {
+            list.insert(pos, i);
+            expected.insert(expected.begin() + pos, i);
+        }
+        if (i % 500 == 0) snapshots.emplace_back(list.snapshot(), expected);
+    }
+    EXPECT_EQ(to_vector(list), expected);
+    for (const auto& [snapshot, values] : snapshots) EXPECT_EQ(to_vector(snapshot), values);
+}
+
+TEST(CowUnrolledList, AppendsFillNodes) {
+    allocation_count::value = 0;
+    cow_unrolled_list<int, 8, counting_allocator<int>> list;
+    for (int i = 0; i < 64; ++i) list.push_back(i);
+    // The spine, a chunk, eight full nodes and the growth of both vectors
+    EXPECT_EQ(allocation_count::value, 1u + 1u + 8u + 1u + 4u);
+    for (int i = 0; i < 64; ++i) EXPECT_EQ(list[i], i);
+
+    auto snapshot = list.snapshot();
+    allocation_count::value = 0;
+    list.push_back(64);
+    // Copies of the spine and the chunk with their vectors, the growth of the
+    // copied chunk's vector and a new node, no element is copied
+    EXPECT_EQ(allocation_count::value, 6u);
+    EXPECT_EQ(snapshot.size(), 64u);
+}
+
+TEST(CowUnrolledList, WriteAfterSnapshotCopiesOneChunk) {
+    cow_unrolled_list<int, 4, counting_allocator<int>> list;
+    for (int i = 0; i < 40'000; ++i) list.push_back(i);
+    auto snapshot = list.snapshot();
+    // A copy of the pointers to all 10'000 nodes, what a flat spine would cost
+    size_t flat_spine = 10'000 * sizeof(std::shared_ptr<int>);
+
+    for (size_t pos : {size_t(0), size_t(20'000), size_t(39'999)}) {
+        allocation_count::bytes = 0;
+        list.assign(pos, -1);
+        EXPECT_LT(allocation_count::bytes, flat_spine / 20);
+        snapshot = list.snapshot();
+    }
+    allocation_count::bytes = 0;
+    list.insert(20'000, -2); // Splits a node and its full chunk
+    EXPECT_LT(allocation_count::bytes, flat_spine / 10);
+    EXPECT_EQ(list[20'000], -2);
+    EXPECT_EQ(list[20'001], -1);
+    EXPECT_EQ(*std::next(snapshot.begin(), 20'000), -1);
+    EXPECT_EQ(list.size(), 40'001u);
+}
+
+TEST(CowUnrolledList, SharedNodesAreFreedOnce) {
+    {
+        cow_unrolled_list<tracked, 4> list;
+        for (int i = 0; i < 10; ++i) list.push_back(tracked(i));
+        auto snapshot = list.snapshot();
+        list.insert(2, tracked(100)); // Splits a shared node by copying it
+        list.erase(9);
+        EXPECT_EQ(snapshot.size(), 10u);
+        EXPECT_EQ(list.size(), 10u);
+        list.clear();
+        EXPECT_EQ(tracked::live, 10);
+    }
+    EXPECT_EQ(tracked::live, 0);
+}
+
+TEST(CowUnrolledList, ReaderThreadScansSnapshots) {
+    cow_unrolled_list<int, 16> list;
+    for (int i = 0; i < 1000; ++i) list.push_back(i);
+
+    auto snapshot = list.snapshot();
+    long sum = 0;
+    std::thread reader([&snapshot, &sum] {
+        for (int round = 0; round < 20; ++round) {
+            for (int value : snapshot) sum += value;
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        list.assign(i, -1);
+        list.push_back(i);
+    }
+    reader.join();
+    EXPECT_EQ(sum, 20L * 999 * 1000 / 2);
+    EXPECT_EQ(list.size(), 2000u);
+    EXPECT_EQ(list[0], -1);
+}
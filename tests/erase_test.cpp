@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+} // namespace
+
+TEST(Erase, LastElementLeavesNoEmptyHead) {
+    unrolled_list<int, 4> list = {1};
+    auto it = list.erase(list.begin());
+    EXPECT_EQ(it, list.end());
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.begin(), list.end());
+    EXPECT_EQ(list.stats().node_count, 0u);
+    list.push_back(2);
+    list.push_back(3);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{2, 3}));
+}
+
+TEST(Erase, EmptiedHeadNodeIsReleased) {
+    unrolled_list<int, 2> list = {1, 2, 3, 4};
+    list.erase(list.begin());
+    list.erase(list.begin());
+    EXPECT_EQ(list.stats().node_count, 1u);
+    EXPECT_EQ(list.front(), 3);
+    EXPECT_EQ(*list.begin(), 3);
+}
+
+TEST(Erase, ReturnsTheFollowingElementAcrossNodes) {
+    unrolled_list<int, 4> list = {0, 1, 2, 3, 4, 5, 6, 7};
+    auto it = list.erase(std::next(list.begin(), 3)); // Last element of the first node
+    ASSERT_NE(it, list.end());
+    EXPECT_EQ(*it, 4);
+    EXPECT_EQ(std::distance(list.begin(), it), 3);
+
+    it = list.erase(std::next(list.begin(), 6));
+    EXPECT_EQ(it, list.end());
+    EXPECT_EQ(to_vector(list), (std::vector<int>{0, 1, 2, 4, 5, 6}));
+}
+
+TEST(PopBack, DownToEmptyAndRefill) {
+    unrolled_list<int, 2> list = {1, 2, 3};
+    list.pop_back();
+    list.pop_back();
+    list.pop_back();
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.begin(), list.end());
+    EXPECT_EQ(list.stats().node_count, 0u);
+    list.pop_back(); // No-op on an empty list
+    list.push_front(5);
+    list.push_back(6);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{5, 6}));
+    EXPECT_EQ(list.back(), 6);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <unrolled_list.h>
+
+namespace {
+
+template<size_t NodeMaxSize, bool Timing = false>
+using counted_list = unrolled_list<int, NodeMaxSize, std::allocator<int>, unrolled_list_counting_instrumentation<Timing>>;
+
+template<typename List>
+size_t timed(const List& list, unrolled_list_operation operation) {
+    const auto& histogram = list.instrumentation().counters().latency_histogram[size_t(operation)];
+    return std::accumulate(histogram.begin(), histogram.end(), size_t(0));
+}
+
+} // namespace
+
+TEST(CountingInstrumentation, CountsNodesSplitsAndShifts) {
+    counted_list<4> list;
+    for (int i = 0; i < 8; ++i) list.push_back(i); // [0 1 2 3] [4 5 6 7]
+    const auto& counters = list.instrumentation().counters();
+    EXPECT_EQ(counters.nodes_created, 2u);
+    EXPECT_EQ(counters.shifts, 0u); // Appends shift nothing
+
+    list.insert(std::next(list.begin()), 9); // Splits the full head, then shifts one element
+    EXPECT_EQ(counters.nodes_created, 3u);
+    EXPECT_EQ(counters.splits, 1u);
+    EXPECT_EQ(counters.split_moves, 2u);
+    EXPECT_EQ(counters.shifts, 1u);
+    EXPECT_EQ(counters.shifted_elements, 1u);
+
+    list.erase(list.begin()); // [9 1], shifts two
+    list.push_front(5); // [5 9 1], shifts two
+    list.pop_front(); // [9 1], shifts two
+    EXPECT_EQ(counters.shifts, 4u);
+    EXPECT_EQ(counters.shifted_elements, 7u);
+
+    list.erase(std::next(list.begin(), list.size() - 1)); // Last element of its node, nothing to shift
+    EXPECT_EQ(counters.shifts, 4u);
+
+    list.clear();
+    EXPECT_EQ(counters.nodes_destroyed, counters.nodes_created);
+    list.instrumentation().reset();
+    EXPECT_EQ(counters.nodes_created, 0u);
+}
+
+TEST(CountingInstrumentation, CountsMergedElements) {
+    counted_list<4> odds = {1, 3, 5, 7};
+    counted_list<4> evens = {2, 4, 6, 8};
+    odds.merge(evens);
+    const auto& counters = odds.instrumentation().counters();
+    EXPECT_EQ(counters.merges, 1u);
+    EXPECT_EQ(counters.merge_moves, 8u);
+
+    counted_list<4> larger = {10, 11, 12, 13, 14};
+    odds.merge(larger); // Ordered, the chain is relinked without moving an element
+    EXPECT_EQ(counters.merges, 2u);
+    EXPECT_EQ(counters.merge_moves, 8u);
+    EXPECT_EQ(odds.size(), 13u);
+}
+
+TEST(CountingInstrumentation, SharedCountersAcrossThreads) {
+    constexpr int Threads = 4;
+    unrolled_list_counters shared;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&shared] {
+            counted_list<10> list;
+            list.instrumentation() = unrolled_list_counting_instrumentation<>(shared);
+            for (int i = 0; i < 1000; ++i) list.push_back(i);
+            for (int i = 0; i < 1000; ++i) list.pop_front();
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    EXPECT_EQ(shared.nodes_created, size_t(Threads * 100));
+    EXPECT_EQ(shared.nodes_destroyed, size_t(Threads * 100));
+    EXPECT_EQ(shared.shifted_elements, size_t(Threads * 100 * 45)); // 9 + 8 + ... + 0 per node
+}
+
+TEST(CountingInstrumentation, TimesEveryOperation) {
+    counted_list<8, true> list;
+    for (int i = 0; i < 100; ++i) list.push_back(i);
+    for (int i = 0; i < 30; ++i) list.push_front(i);
+    for (int i = 0; i < 20; ++i) list.insert(std::next(list.begin(), 50), i);
+    for (int i = 0; i < 10; ++i) list.erase(std::next(list.begin(), 40));
+    for (int i = 0; i < 5; ++i) list.pop_back();
+    for (int i = 0; i < 7; ++i) list.pop_front();
+
+    EXPECT_EQ(timed(list, unrolled_list_operation::push_back), 100u);
+    EXPECT_EQ(timed(list, unrolled_list_operation::push_front), 30u);
+    EXPECT_EQ(timed(list, unrolled_list_operation::emplace), 20u);
+    EXPECT_EQ(timed(list, unrolled_list_operation::erase), 10u);
+    EXPECT_EQ(timed(list, unrolled_list_operation::pop_back), 5u);
+    EXPECT_EQ(timed(list, unrolled_list_operation::pop_front), 7u);
+}
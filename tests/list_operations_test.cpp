@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+unrolled_list<int, 4> iota(int first, int last, int step = 1) {
+    unrolled_list<int, 4> list;
+    for (int i = first; i < last; i += step) list.push_back(i);
+    return list;
+}
+
+} // namespace
+
+TEST(Reverse, ReversesAcrossNodes) {
+    auto list = iota(0, 11);
+    list.reverse();
+    EXPECT_EQ(to_vector(list), (std::vector<int>{10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0}));
+    EXPECT_EQ(list.front(), 10);
+    EXPECT_EQ(list.back(), 0);
+    list.push_back(-1);
+    list.push_front(11);
+    EXPECT_EQ(to_vector(list), (std::vector<int>{11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, -1}));
+
+    unrolled_list<int, 4> empty;
+    empty.reverse();
+    EXPECT_TRUE(empty.empty());
+}
+
+TEST(Rotate, InsideANode) {
+    auto list = iota(0, 10);
+    auto old_first = list.rotate(std::next(list.cbegin(), 6));
+    EXPECT_EQ(to_vector(list), (std::vector<int>{6, 7, 8, 9, 0, 1, 2, 3, 4, 5}));
+    EXPECT_EQ(*old_first, 0);
+    EXPECT_EQ(std::distance(list.begin(), old_first), 4);
+}
+
+TEST(Rotate, AtANodeBoundary) {
+    auto list = iota(0, 12);
+    list.rotate(std::next(list.cbegin(), 4));
+    EXPECT_EQ(to_vector(list), (std::vector<int>{4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3}));
+    EXPECT_EQ(list.back(), 3);
+}
+
+TEST(Rotate, BeginAndEndAreNoOps) {
+    auto list = iota(0, 5);
+    EXPECT_EQ(list.rotate(list.cbegin()), list.end());
+    EXPECT_EQ(list.rotate(list.cend()), list.begin());
+    EXPECT_EQ(to_vector(list), (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST(Merge, Interleaved) {
+    auto evens = iota(0, 20, 2);
+    auto odds = iota(1, 20, 2);
+    evens.merge(odds);
+    EXPECT_EQ(to_vector(evens), to_vector(iota(0, 20)));
+    EXPECT_EQ(evens.size(), 20u);
+    EXPECT_TRUE(odds.empty());
+    EXPECT_EQ(evens.stats().node_count, 5u);
+    EXPECT_EQ(evens.back(), 19);
+}
+
+TEST(Merge, OrderedChainsAreRelinked) {
+    auto low = iota(0, 6);
+    low.merge(iota(6, 13));
+    EXPECT_EQ(to_vector(low), to_vector(iota(0, 13)));
+
+    auto high = iota(10, 15);
+    high.merge(iota(0, 10));
+    EXPECT_EQ(to_vector(high), to_vector(iota(0, 15)));
+
+    unrolled_list<int, 4> empty;
+    empty.merge(iota(0, 3));
+    EXPECT_EQ(to_vector(empty), (std::vector<int>{0, 1, 2}));
+}
+
+TEST(Merge, IsStable) {
+    using entry = std::pair<int, char>;
+    auto by_key = [](const entry& a, const entry& b) { return a.first < b.first; };
+    unrolled_list<entry, 3> left = {{1, 'a'}, {2, 'a'}, {2, 'b'}, {5, 'a'}};
+    unrolled_list<entry, 3> right = {{0, 'x'}, {2, 'x'}, {5, 'x'}, {6, 'x'}};
+    left.merge(right, by_key);
+    std::string order;
+    for (const entry& e : left) order += std::to_string(e.first) + e.second;
+    EXPECT_EQ(order, "0x1a2a2b2x5a5x6x");
+}
+
+TEST(Merge, CustomComparator) {
+    unrolled_list<int, 4> left = {9, 7, 3, 1};
+    unrolled_list<int, 4> right = {8, 6, 5, 2, 0};
+    left.merge(right, std::greater<int>());
+    EXPECT_EQ(to_vector(left), (std::vector<int>{9, 8, 7, 6, 5, 3, 2, 1, 0}));
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <mapped_unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+// File in the temporary directory, removed when the test ends
+class MappedUnrolledList : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = std::string("mapped_unrolled_list_test_") + std::to_string(::getpid()) + "_" +
+                    ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        path = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+};
+
+} // namespace
+
+TEST_F(MappedUnrolledList, MatchesVectorAndReopens) {
+    std::vector<int64_t> expected;
+    {
+        auto list = mapped_unrolled_list<int64_t, 8>::create(path);
+        std::mt19937 random(5);
+        for (int i = 0; i < 3000; ++i) {
+            size_t pos = expected.empty() ? 0 : random() % (expected.size() + 1);
+            switch (random() % 3) {
+                case 0:
+                    list.push_back(i);
+                    expected.push_back(i);
+                    break;
+                case 1:
+                    list.insert(pos, i);
+                    expected.insert(expected.begin() + pos, i);
+                    break;
+                default:
+                    if (pos < expected.size()) {
+                        list.erase(pos);
+                        expected.erase(expected.begin() + pos);
+                    }
+            }
+        }
+        EXPECT_EQ(to_vector(list), expected);
+        list.flush();
+    }
+
+    mapped_unrolled_list<int64_t, 8> reopened(path);
+    EXPECT_EQ(to_vector(reopened), expected);
+    ASSERT_EQ(reopened.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i += 17) EXPECT_EQ(reopened[i], expected[i]);
+    EXPECT_EQ(reopened.front(), expected.front());
+    EXPECT_EQ(reopened.back(), expected.back());
+    EXPECT_THROW(reopened.at(expected.size()), std::out_of_range);
+}
+
+TEST_F(MappedUnrolledList, AppendsFillNodes) {
+    auto list = mapped_unrolled_list<uint64_t, 64>::create(path);
+    for (uint64_t i = 0; i < 6400; ++i) list.push_back(i);
+    EXPECT_EQ(list.node_count(), 100u);
+    list.push_front(7);
+    list.pop_front();
+    for (uint64_t i = 0; i < 6400; ++i) EXPECT_EQ(list[i], i);
+}
+
+TEST_F(MappedUnrolledList, NodesLargerThanTheInitialFile) {
+    {
+        auto list = mapped_unrolled_list<uint64_t, 16384>::create(path);
+        for (uint64_t i = 0; i < 40000; ++i) list.push_back(i);
+        EXPECT_EQ(list.node_count(), 3u);
+        EXPECT_GE(list.file_size(), 3 * 16384 * sizeof(uint64_t));
+    }
+    mapped_unrolled_list<uint64_t, 16384> reopened(path);
+    ASSERT_EQ(reopened.size(), 40000u);
+    EXPECT_EQ(reopened[39999], 39999u);
+}
+
+TEST_F(MappedUnrolledList, ClearedNodesAreReused) {
+    auto list = mapped_unrolled_list<int, 16>::create(path);
+    for (int i = 0; i < 5000; ++i) list.push_back(i);
+    size_t length = list.file_size();
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.begin(), list.end());
+    for (int i = 0; i < 5000; ++i) list.push_back(-i);
+    EXPECT_EQ(list.file_size(), length);
+    EXPECT_EQ(list.back(), -4999);
+}
+
+TEST_F(MappedUnrolledList, RejectsAnotherLayout) {
+    {
+        auto list = mapped_unrolled_list<int, 16>::create(path);
+        list.push_back(1);
+    }
+    EXPECT_THROW((mapped_unrolled_list<int, 32>(path)), std::runtime_error);
+    EXPECT_THROW((mapped_unrolled_list<int64_t, 16>(path)), std::runtime_error);
+    EXPECT_EQ((mapped_unrolled_list<int, 16>(path)).front(), 1);
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <mpmc_unrolled_queue.h>
+
+namespace {
+
+constexpr int Producers = 3;
+
+// Producer number and sequence number packed into one value. Moves yield, so
+// that producers get descheduled between claiming a slot and publishing it.
+struct sequenced {
+    int value = 0;
+
+    sequenced() = default;
+    sequenced(int producer, int sequence) : value(producer << 24 | sequence) {}
+    sequenced(const sequenced&) = default;
+    sequenced(sequenced&& other) noexcept : value(other.value) { std::this_thread::yield(); }
+    sequenced& operator=(const sequenced&) = default;
+    sequenced& operator=(sequenced&&) noexcept = default;
+
+    int producer() const { return value >> 24; }
+    int sequence() const { return value & 0xFFFFFF; }
+};
+
+// Runs a hook from inside the n-th move construction, i.e. while a producer
+// has claimed a slot and not yet published it. Counts live objects.
+struct intercepted {
+    static inline int live = 0;
+    static inline int moves_until_hook = 0;
+    static inline std::function<void()> hook;
+    int value;
+
+    explicit intercepted(int value) : value(value) { ++live; }
+    intercepted(const intercepted& other) : value(other.value) { ++live; }
+    intercepted(intercepted&& other) noexcept : value(other.value) {
+        ++live;
+        if (hook && --moves_until_hook == 0) std::exchange(hook, nullptr)();
+    }
+    intercepted& operator=(const intercepted&) = default;
+    intercepted& operator=(intercepted&&) noexcept = default;
+    ~intercepted() { --live; }
+};
+
+// Consumers spin on a queue that producers fill in batches, so they keep
+// overtaking producers inside claimed runs. Every element must arrive exactly
+// once, and each consumer must see the elements of one producer in push order.
+void run_producers_and_consumers(int consumers) {
+    constexpr int PerProducer = 20000;
+    constexpr int Batch = 7;
+    mpmc_unrolled_queue<sequenced, 16> queue;
+    std::atomic<int> remaining{Producers * PerProducer};
+    std::vector<std::vector<sequenced>> received(consumers);
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            std::vector<sequenced> batch;
+            while (remaining.load() > 0) {
+                batch.clear();
+                size_t popped = c % 2 ? queue.pop_n(std::back_inserter(batch), 5) : 0;
+                if (!popped) {
+                    if (auto value = queue.try_pop()) batch.push_back(*value);
+                }
+                remaining -= int(batch.size());
+                received[c].insert(received[c].end(), batch.begin(), batch.end());
+            }
+        });
+    }
+    for (int p = 0; p < Producers; ++p) {
+        threads.emplace_back([&, p] {
+            std::vector<sequenced> batch;
+            for (int i = 0; i < PerProducer; i += Batch) {
+                batch.clear();
+                for (int k = i; k < std::min(i + Batch, PerProducer); ++k) batch.emplace_back(p, k);
+                if (batch.size() == 1) {
+                    queue.push(batch[0]);
+                } else {
+                    queue.push_n(batch.begin(), batch.size());
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    std::vector<int> all;
+    for (const auto& values : received) {
+        std::vector<int> last(Producers, -1);
+        for (const sequenced& item : values) {
+            ASSERT_LT(last[item.producer()], item.sequence()) << "producer " << item.producer() << " reordered";
+            last[item.producer()] = item.sequence();
+            all.push_back(item.value);
+        }
+    }
+    ASSERT_EQ(all.size(), size_t(Producers * PerProducer));
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+}
+
+} // namespace
+
+TEST(MpmcUnrolledQueue, FifoAcrossNodes) {
+    mpmc_unrolled_queue<std::string, 4> queue;
+    EXPECT_FALSE(queue.try_pop().has_value());
+    for (int i = 0; i < 30; ++i) queue.push(std::to_string(i));
+    for (int i = 0; i < 30; ++i) EXPECT_EQ(queue.try_pop(), std::to_string(i));
+    std::string out;
+    EXPECT_FALSE(queue.try_pop(out));
+}
+
+TEST(MpmcUnrolledQueue, BatchesKeepOrder) {
+    mpmc_unrolled_queue<int, 8> queue;
+    std::vector<int> values(50);
+    for (int i = 0; i < 50; ++i) values[i] = i;
+    queue.push_n(values.begin(), 20);
+    queue.push(20);
+    queue.push_n(values.begin() + 21, 29);
+
+    std::vector<int> out;
+    EXPECT_EQ(queue.pop_n(std::back_inserter(out), 15), 15u);
+    EXPECT_EQ(queue.pop_n(std::back_inserter(out), 100), 35u);
+    EXPECT_EQ(out, values);
+    EXPECT_EQ(queue.pop_n(std::back_inserter(out), 10), 0u);
+}
+
+TEST(MpmcUnrolledQueue, DestroysRemainingElements) {
+    auto shared = std::make_shared<int>(0);
+    {
+        mpmc_unrolled_queue<std::shared_ptr<int>, 4> queue;
+        for (int i = 0; i < 10; ++i) queue.push(shared);
+        for (int i = 0; i < 3; ++i) queue.try_pop();
+        EXPECT_EQ(shared.use_count(), 8);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+// Replays a fixed interleaving from one thread: while producer A is
+// publishing a batch, a consumer takes A's first element and gives up on the
+// rest of the run, and producer B pushes a whole batch behind it. A's
+// remaining elements must be retried behind B's batch, still in push order.
+TEST(MpmcUnrolledQueue, ConsumerOvertakingABatchKeepsItsOrder) {
+    {
+        mpmc_unrolled_queue<intercepted, 8> queue;
+        std::vector<int> out;
+        auto pop = [&queue, &out] {
+            auto value = queue.try_pop();
+            if (value) out.push_back(value->value);
+            return value.has_value();
+        };
+
+        std::vector<intercepted> a = {intercepted(0), intercepted(1), intercepted(2), intercepted(3)};
+        std::vector<intercepted> b = {intercepted(100), intercepted(101), intercepted(102)};
+        intercepted::moves_until_hook = 2; // A's second element, slots 0-3 are claimed and 0 is published
+        intercepted::hook = [&] {
+            EXPECT_TRUE(pop()); // A0
+            queue.push_n(b.begin(), b.size()); // Slots 4-6
+            EXPECT_TRUE(pop()); // Gives up on slots 1-3, then takes B's first element
+        };
+        queue.push_n(a.begin(), a.size());
+        EXPECT_FALSE(intercepted::hook);
+
+        while (pop()) {}
+        EXPECT_EQ(out, (std::vector<int>{0, 100, 101, 102, 1, 2, 3}));
+        queue.push(intercepted(4));
+        EXPECT_TRUE(pop());
+        EXPECT_EQ(out.back(), 4);
+    }
+    EXPECT_EQ(intercepted::live, 0);
+}
+
+// One consumer sees every element, so any reordering within a batch shows
+TEST(MpmcUnrolledQueue, ProducersKeepFifoWithOneConsumer) {
+    run_producers_and_consumers(1);
+}
+
+TEST(MpmcUnrolledQueue, ProducersKeepFifoWithManyConsumers) {
+    run_producers_and_consumers(3);
+}
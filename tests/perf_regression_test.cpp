@@ -0,0 +1,311 @@
+// Performance regression tests. Every scenario runs at a fixed size and is
+// compared with tests/perf_baselines.txt:
+//   metric - deterministic values (allocations per operation, node counts,
+//            bytes per element) that must not grow beyond the baseline
+//   time   - ns per operation relative to a calibration loop measured in the
+//            same process, so baselines roughly carry over between machines; they may
+//            grow by UNROLLED_LIST_PERF_TOLERANCE (default 0.5, i.e. 50%); they
+//            are skipped when the test is compiled without optimization
+// Run with UNROLLED_LIST_PERF_UPDATE=1 to write the measured values as new
+// baselines into the build directory instead of comparing.
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unrolled_list.h>
+
+#include "bench_harness.h"
+
+namespace {
+
+constexpr size_t NodeMaxSize = 64;
+constexpr size_t LargeSize = 100'000; // Elements for O(1) per element operations
+constexpr size_t SmallSize = 4'096; // Elements for O(n) per element operations
+constexpr size_t Samples = 7; // Timings take the fastest of these
+constexpr size_t Attempts = 3;
+constexpr size_t CalibrationSteps = 1'000'000;
+
+using list = unrolled_list<uint64_t, NodeMaxSize>;
+
+bool updating() {
+    const char* update = std::getenv("UNROLLED_LIST_PERF_UPDATE");
+    return update && *update && *update != '0';
+}
+
+// Values keyed by "<kind> <name>", read from the baselines file. Updates go
+// to a copy in the build directory, the file in the source tree is only
+// replaced by hand.
+class baselines {
+public:
+    static baselines& instance() {
+        static baselines file(UNROLLED_LIST_PERF_BASELINES, UNROLLED_LIST_PERF_UPDATED_BASELINES);
+        return file;
+    }
+
+    bool find(const std::string& key, double& value) const {
+        auto it = values.find(key);
+        if (it == values.end()) return false;
+        value = it->second;
+        return true;
+    }
+
+    // Sets key and rewrites the updated copy, keeping the other entries
+    void update(const std::string& key, double value) {
+        values[key] = value;
+        std::ofstream out(updated_path);
+        out << header << std::setprecision(10);
+        for (const auto& [name, baseline] : values) out << name << " " << baseline << "\n";
+        if (!out) ADD_FAILURE() << "cannot write " << updated_path;
+        if (!announced) std::cout << "updated baselines written to " << updated_path << "\n";
+        announced = true;
+    }
+
+private:
+    std::string updated_path;
+    std::string header; // Leading comment lines, preserved on update
+    std::map<std::string, double> values;
+    bool announced = false;
+
+    baselines(const std::string& path, std::string updated_path) : updated_path(std::move(updated_path)) {
+        // ctest runs every case in its own process, so updates accumulate in the copy
+        bool continued = updating() && std::filesystem::exists(this->updated_path);
+        std::ifstream in(continued ? this->updated_path : path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                if (values.empty()) header += line + "\n";
+                continue;
+            }
+            std::istringstream fields(line);
+            std::string kind, name;
+            double value;
+            if (fields >> kind >> name >> value) values[kind + " " + name] = value;
+        }
+    }
+};
+
+double tolerance() {
+    const char* text = std::getenv("UNROLLED_LIST_PERF_TOLERANCE");
+    return text ? std::atof(text) : 0.5;
+}
+
+// Deterministic metrics compare exactly up to the rounding in the file, an
+// improvement only asks for a baseline update
+void check_metric(const std::string& name, double value) {
+    std::string key = "metric " + name;
+    if (updating()) {
+        baselines::instance().update(key, value);
+        return;
+    }
+    double baseline;
+    if (!baselines::instance().find(key, baseline)) {
+        GTEST_SKIP() << "no baseline for " << key << ", run with UNROLLED_LIST_PERF_UPDATE=1";
+    }
+    EXPECT_LE(value, baseline * (1 + 1e-8)) << name << " regressed";
+    if (value < baseline * (1 - 1e-8)) {
+        std::cout << name << " improved from " << baseline << " to " << value << ", consider updating the baseline\n";
+    }
+}
+
+// Fastest of Samples calls of sample(), in ns per operation
+template<typename Sample>
+double fastest_ns_per_op(size_t ops, Sample sample) {
+    double best = 0;
+    for (size_t i = 0; i < Samples; ++i) {
+        double ns = sample() * 1e9 / double(ops);
+        if (i == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+// ns per step of a dependent multiply-add chain, the unit the time baselines
+// are expressed in. It touches no memory, so it tracks the core clock without
+// picking up allocator or page fault noise. It is measured again next to every
+// measurement, so the clock and the load are the same for both.
+double calibration_ns() {
+    return fastest_ns_per_op(CalibrationSteps, [] {
+        volatile uint64_t seed = 1;
+        return bench::time_seconds([&] {
+            uint64_t x = seed;
+            for (size_t i = 0; i < CalibrationSteps; ++i) x = x * 6364136223846793005ull + 1442695040888963407ull;
+            bench::do_not_optimize(x);
+        });
+    });
+}
+
+// One measurement in calibration units
+template<typename Sample>
+double relative_ns_per_op(size_t ops, Sample sample) {
+    double op = fastest_ns_per_op(ops, sample);
+    return op / calibration_ns();
+}
+
+// A measurement over budget is repeated up to Attempts times before it fails,
+// so a burst of load on the machine does not fail the build
+template<typename Sample>
+void check_time(const std::string& name, size_t ops, Sample sample) {
+#ifndef __OPTIMIZE__
+    GTEST_SKIP() << "timings are only compared in optimized builds";
+#endif
+    double relative = relative_ns_per_op(ops, sample);
+    std::string key = "time " + name;
+    if (updating()) {
+        baselines::instance().update(key, relative);
+        return;
+    }
+    double baseline;
+    if (!baselines::instance().find(key, baseline)) {
+        GTEST_SKIP() << "no baseline for " << key << ", run with UNROLLED_LIST_PERF_UPDATE=1";
+    }
+    for (size_t attempt = 1; attempt < Attempts && relative > baseline * (1 + tolerance()); ++attempt) {
+        relative = std::min(relative, relative_ns_per_op(ops, sample));
+    }
+    EXPECT_LE(relative, baseline * (1 + tolerance()))
+        << name << " takes " << relative << " calibration units per operation, baseline " << baseline;
+}
+
+list filled(size_t count) {
+    list l;
+    for (size_t i = 0; i < count; ++i) l.push_back(i);
+    return l;
+}
+
+double bytes_per_element(const list& l) {
+    auto stats = l.stats();
+    return double(stats.header_bytes + stats.block_bytes) / double(stats.element_count);
+}
+
+} // namespace
+
+TEST(PerfMetrics, PushBack) {
+    list l = filled(LargeSize);
+    auto stats = l.stats();
+    EXPECT_EQ(stats.node_count, (LargeSize + NodeMaxSize - 1) / NodeMaxSize);
+    check_metric("push_back/node_count", double(stats.node_count));
+    check_metric("push_back/allocations_per_op", double(stats.allocations) / double(LargeSize));
+    check_metric("push_back/bytes_per_element", bytes_per_element(l));
+}
+
+TEST(PerfMetrics, PushFront) {
+    list l;
+    for (size_t i = 0; i < LargeSize; ++i) l.push_front(i);
+    auto stats = l.stats();
+    check_metric("push_front/node_count", double(stats.node_count));
+    check_metric("push_front/allocations_per_op", double(stats.allocations) / double(LargeSize));
+    check_metric("push_front/bytes_per_element", bytes_per_element(l));
+}
+
+TEST(PerfMetrics, InsertMiddle) {
+    list l;
+    for (size_t i = 0; i < SmallSize; ++i) l.insert(std::next(l.cbegin(), l.size() / 2), i);
+    auto stats = l.stats();
+    check_metric("insert_middle/node_count", double(stats.node_count));
+    check_metric("insert_middle/allocations_per_op", double(stats.allocations) / double(SmallSize));
+    check_metric("insert_middle/bytes_per_element", bytes_per_element(l));
+}
+
+TEST(PerfMetrics, RandomInsertErase) {
+    list l = filled(SmallSize);
+    std::mt19937_64 random(42);
+    for (size_t i = 0; i < SmallSize; ++i) {
+        l.insert(std::next(l.cbegin(), random() % (l.size() + 1)), i);
+        l.erase(std::next(l.cbegin(), random() % l.size()));
+    }
+    auto stats = l.stats();
+    check_metric("random_insert_erase/node_count", double(stats.node_count));
+    check_metric("random_insert_erase/allocations_per_op", double(stats.allocations) / double(2 * SmallSize));
+    check_metric("random_insert_erase/bytes_per_element", bytes_per_element(l));
+}
+
+// A FIFO at steady state allocates one node per NodeMaxSize pushes
+TEST(PerfMetrics, Queue) {
+    list l = filled(SmallSize);
+    auto before = l.stats();
+    for (size_t i = 0; i < LargeSize; ++i) {
+        l.push_back(i);
+        l.pop_front();
+    }
+    auto after = l.stats();
+    check_metric("queue/allocations_per_op", double(after.allocations - before.allocations) / double(LargeSize));
+    check_metric("queue/node_count", double(after.node_count));
+}
+
+TEST(PerfTiming, PushBack) {
+    check_time("push_back", LargeSize, [] {
+        list l;
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < LargeSize; ++i) l.push_back(i);
+        });
+    });
+}
+
+TEST(PerfTiming, PushFront) {
+    check_time("push_front", SmallSize, [] {
+        list l;
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) l.push_front(i);
+        });
+    });
+}
+
+TEST(PerfTiming, PopFront) {
+    check_time("pop_front", SmallSize, [] {
+        list l = filled(SmallSize);
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) l.pop_front();
+        });
+    });
+}
+
+TEST(PerfTiming, InsertMiddle) {
+    check_time("insert_middle", SmallSize, [] {
+        list l = filled(SmallSize);
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) l.insert(std::next(l.cbegin(), l.size() / 2), i);
+        });
+    });
+}
+
+TEST(PerfTiming, EraseMiddle) {
+    check_time("erase_middle", SmallSize, [] {
+        list l = filled(2 * SmallSize);
+        return bench::time_seconds([&] {
+            for (size_t i = 0; i < SmallSize; ++i) l.erase(std::next(l.cbegin(), l.size() / 2));
+        });
+    });
+}
+
+TEST(PerfTiming, Iterate) {
+    list l = filled(LargeSize);
+    check_time("iterate", LargeSize, [&] {
+        return bench::time_seconds([&] {
+            uint64_t sum = 0;
+            for (uint64_t value : l) sum += value;
+            bench::do_not_optimize(sum);
+        });
+    });
+}
+
+TEST(PerfTiming, Copy) {
+    list l = filled(LargeSize);
+    check_time("copy", LargeSize, [&] {
+        return bench::time_seconds([&] {
+            list copy(l);
+            bench::do_not_optimize(copy.size());
+        });
+    });
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <persistent_unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+// Counts allocations of every rebound type together
+struct allocation_count {
+    static inline size_t value = 0;
+};
+
+template<typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        ++allocation_count::value;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const counting_allocator<U>&) const noexcept { return true; }
+};
+
+// Counts live objects to check that shared leaves are freed exactly once
+struct tracked {
+    static inline int live = 0;
+    int value;
+
+    explicit tracked(int value) : value(value) { ++live; }
+    tracked(const tracked& other) : value(other.value) { ++live; }
+    ~tracked() { --live; }
+};
+
+} // namespace
+
+TEST(PersistentUnrolledList, MatchesVector) {
+    persistent_unrolled_list<int, 4, 3> list;
+    std::vector<int> expected;
+    std::mt19937 random(11);
+    for (int i = 0; i < 3000; ++i) {
+        size_t pos = expected.empty() ? 0 : random() % (expected.size() + 1);
+        switch (random() % 4) {
+            case 0:
+                list = list.push_back(i);
+                expected.push_back(i);
+                break;
+            case 1:
+                list = list.insert(pos, i);
+                expected.insert(expected.begin() + pos, i);
+                break;
+            case 2:
+                if (pos < expected.size()) {
+                    list = list.erase(pos);
+                    expected.erase(expected.begin() + pos);
+                }
+                break;
+            default:
+                if (pos < expected.size()) {
+                    list = list.set(pos, -i);
+                    expected[pos] = -i;
+                }
+        }
+    }
+    EXPECT_EQ(to_vector(list), expected);
+    ASSERT_EQ(list.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) EXPECT_EQ(list[i], expected[i]);
+    EXPECT_EQ(list.front(), expected.front());
+    EXPECT_EQ(list.back(), expected.back());
+    EXPECT_THROW(list.at(expected.size()), std::out_of_range);
+}
+
+TEST(PersistentUnrolledList, OldVersionsStayIntact) {
+    using list = persistent_unrolled_list<std::string, 4, 4>;
+    std::vector<list> versions = {list()};
+    for (int i = 0; i < 100; ++i) versions.push_back(versions.back().push_back(std::to_string(i)));
+    versions.push_back(versions.back().set(50, "x"));
+    versions.push_back(versions.back().erase(0));
+    versions.push_back(versions.back().push_front("y"));
+
+    EXPECT_TRUE(versions[0].empty());
+    for (int i = 0; i <= 100; ++i) {
+        ASSERT_EQ(versions[i].size(), size_t(i));
+        if (i > 0) {
+            EXPECT_EQ(versions[i].back(), std::to_string(i - 1));
+        }
+    }
+    EXPECT_EQ(versions[100][50], "50");
+    EXPECT_EQ(versions[101][50], "x");
+    EXPECT_EQ(versions[102][0], "1");
+    EXPECT_EQ(versions[103][0], "y");
+    EXPECT_NE(versions[100], versions[101]);
+    EXPECT_EQ(versions[101], versions[101].set(50, "x"));
+}
+
+TEST(PersistentUnrolledList, UpdatesShareUntouchedNodes) {
+    using list = persistent_unrolled_list<int, 8, 4, counting_allocator<int>>;
+    list base;
+    for (int i = 0; i < 1000; ++i) base = base.push_back(i);
+
+    allocation_count::value = 0;
+    list changed = base.set(500, -1);
+    size_t path = allocation_count::value; // One leaf plus one index node per level
+    EXPECT_GE(path, 2u);
+    EXPECT_LE(path, 8u);
+
+    allocation_count::value = 0;
+    list erased = changed.erase(10);
+    // Merges with a neighbour may cascade, copying up to two nodes and the parent per level
+    EXPECT_LE(allocation_count::value, 3 * path);
+    EXPECT_EQ(base[500], 500);
+    EXPECT_EQ(changed[500], -1);
+    EXPECT_EQ(erased[499], -1);
+}
+
+TEST(PersistentUnrolledList, HeightShrinksWithErases) {
+    using list = persistent_unrolled_list<int, 8, 4, counting_allocator<int>>;
+    auto path_length = [](const list& l) { // set() copies one leaf plus one index node per level
+        allocation_count::value = 0;
+        [[maybe_unused]] list changed = l.set(0, -1);
+        return allocation_count::value;
+    };
+
+    list base;
+    for (int i = 0; i < 4096; ++i) base = base.push_back(i);
+    EXPECT_GE(path_length(base), 6u);
+
+    std::mt19937 random(5);
+    list small = base;
+    while (small.size() > 8) small = small.erase(random() % small.size());
+    EXPECT_LE(path_length(small), 2u); // At most two leaves under one index node
+    std::vector<int> values = to_vector(small);
+    EXPECT_EQ(values.size(), 8u);
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+    EXPECT_EQ(base.size(), 4096u);
+}
+
+TEST(PersistentUnrolledList, SharedLeavesAreFreedOnce) {
+    {
+        persistent_unrolled_list<tracked, 4, 2> list;
+        for (int i = 0; i < 20; ++i) list = list.push_back(tracked(i));
+        auto older = list;
+        list = list.erase(3).insert(7, tracked(100)).set(0, tracked(-1));
+        EXPECT_EQ(older.size(), 20u);
+        EXPECT_EQ(list.size(), 20u);
+        older = {};
+        list = list.pop_back().pop_front();
+        EXPECT_EQ(tracked::live, 18);
+    }
+    EXPECT_EQ(tracked::live, 0);
+}
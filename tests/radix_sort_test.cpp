@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+struct record {
+    int key;
+    std::string name;
+};
+
+} // namespace
+
+TEST(RadixSort, SortsUnsigned) {
+    unrolled_list<uint32_t, 8> list;
+    std::vector<uint32_t> expected;
+    std::mt19937 random(1);
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t value = random();
+        list.push_back(value);
+        expected.push_back(value);
+    }
+    list.radix_sort();
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(to_vector(list), expected);
+}
+
+TEST(RadixSort, SortsSignedAndFloatingPoint) {
+    unrolled_list<int64_t, 4> integers = {5, -3, 0, INT64_MIN, 42, -42, INT64_MAX};
+    integers.radix_sort();
+    EXPECT_EQ(to_vector(integers), (std::vector<int64_t>{INT64_MIN, -42, -3, 0, 5, 42, INT64_MAX}));
+
+    unrolled_list<double, 4> doubles = {1.5, -0.25, 3.0, -7.0, 0.0, 2.25};
+    doubles.radix_sort();
+    EXPECT_EQ(to_vector(doubles), (std::vector<double>{-7.0, -0.25, 0.0, 1.5, 2.25, 3.0}));
+}
+
+TEST(RadixSort, KeyFunctionIsStable) {
+    unrolled_list<record, 3> list = {{2, "a"}, {1, "b"}, {2, "c"}, {0, "d"}, {1, "e"}, {2, "f"}, {0, "g"}};
+    list.radix_sort([](const record& r) { return r.key; });
+    std::string names;
+    for (const record& r : list) names += r.name;
+    EXPECT_EQ(names, "dgbeacf");
+}
+
+TEST(RadixSort, KeyIsComputedOncePerElement) {
+    unrolled_list<uint64_t, 16> list;
+    for (uint64_t i = 0; i < 500; ++i) list.push_back((i * 7919) % 500 + (i << 40));
+    size_t calls = 0;
+    list.radix_sort([&calls](uint64_t value) {
+        ++calls;
+        return value;
+    });
+    EXPECT_EQ(calls, 500u);
+    EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+}
+
+TEST(RadixSort, PacksNodes) {
+    unrolled_list<int, 10> list;
+    for (int i = 0; i < 95; ++i) list.insert(std::next(list.begin(), list.size() / 2), 95 - i);
+    list.radix_sort();
+    auto stats = list.stats();
+    EXPECT_EQ(stats.node_count, 10u);
+    EXPECT_EQ(list.size(), 95u);
+    EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+}
+
+TEST(RadixSort, ThrowingKeyLeavesListUnchanged) {
+    unrolled_list<int, 4> list = {9, 3, 7, 1, 8, 2};
+    auto before = to_vector(list);
+    EXPECT_THROW(list.radix_sort([](int value) {
+        if (value == 8) throw std::runtime_error("key");
+        return value;
+    }), std::runtime_error);
+    EXPECT_EQ(to_vector(list), before);
+}
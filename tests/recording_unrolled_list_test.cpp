@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <recording_unrolled_list.h>
+
+#include "replay.h"
+
+namespace {
+
+using op = unrolled_list_trace_op;
+
+std::vector<unrolled_list_trace_record> read_all(std::istream& in) {
+    unrolled_list_trace_reader reader(in);
+    std::vector<unrolled_list_trace_record> records;
+    unrolled_list_trace_record record;
+    while (reader.next(record)) records.push_back(record);
+    return records;
+}
+
+// Trace file in the temporary directory, removed when the test ends
+class RecordingUnrolledList : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = std::string("recording_unrolled_list_test_") + std::to_string(::getpid()) + "_" +
+                    ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        path = (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+};
+
+} // namespace
+
+TEST(TraceFormat, WriterAndReaderRoundTrip) {
+    std::vector<unrolled_list_trace_record> written = {
+        {op::push_back}, {op::insert, 0}, {op::insert, 127}, {op::erase, 128}, {op::access, uint64_t(1) << 40},
+        {op::iterate, 3, 300}, {op::iterate, 0, ~uint64_t(0)}, {op::pop_front}, {op::push_front}, {op::pop_back},
+        {op::clear}};
+    std::stringstream stream;
+    {
+        unrolled_list_trace_writer writer(stream, 12, 64);
+        for (const auto& record : written) writer.record(record.op, record.position, record.count);
+        EXPECT_EQ(writer.record_count(), written.size());
+    }
+    // Opcodes are one byte, varints 7 bits per byte
+    EXPECT_EQ(stream.str().size(), sizeof(unrolled_list_trace_header) + 11 + 1 + 1 + 2 + 6 + 1 + 2 + 1 + 10);
+
+    unrolled_list_trace_reader reader(stream);
+    EXPECT_EQ(reader.header().element_size, 12u);
+    EXPECT_EQ(reader.header().node_max_size, 64u);
+    std::vector<unrolled_list_trace_record> read;
+    unrolled_list_trace_record record;
+    while (reader.next(record)) read.push_back(record);
+    ASSERT_EQ(read.size(), written.size());
+    for (size_t i = 0; i < read.size(); ++i) {
+        EXPECT_EQ(read[i].op, written[i].op);
+        EXPECT_EQ(read[i].position, written[i].position);
+        EXPECT_EQ(read[i].count, written[i].count);
+    }
+}
+
+TEST(TraceFormat, RejectsMalformedTraces) {
+    std::stringstream not_a_trace(std::string(32, 'x'));
+    EXPECT_THROW(unrolled_list_trace_reader{not_a_trace}, std::runtime_error);
+
+    std::stringstream stream;
+    {
+        unrolled_list_trace_writer writer(stream, 4, 8);
+        writer.record(op::iterate, 1000, 1000);
+    }
+    std::string bytes = stream.str();
+
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 1)); // Inside the count
+    unrolled_list_trace_reader truncated_reader(truncated);
+    unrolled_list_trace_record record;
+    EXPECT_THROW(truncated_reader.next(record), std::runtime_error);
+
+    std::stringstream unknown(bytes.substr(0, sizeof(unrolled_list_trace_header)) + char(0x7f));
+    unrolled_list_trace_reader unknown_reader(unknown);
+    EXPECT_THROW(unknown_reader.next(record), std::runtime_error);
+}
+
+TEST_F(RecordingUnrolledList, ReplayReproducesTheRecordedList) {
+    std::vector<uint32_t> recorded;
+    uint64_t peak = 0;
+    {
+        std::ofstream out(path, std::ios::binary);
+        recording_unrolled_list<uint32_t, 8> list(out);
+        std::mt19937 random(17);
+        uint32_t key = 0; // Replay numbers inserted elements in the same order
+        for (int i = 0; i < 5000; ++i) {
+            size_t size = list.size();
+            switch (random() % 8) {
+                case 0: list.push_back(key++); break;
+                case 1: list.push_front(key++); break;
+                case 2: list.insert(random() % (size + 1), key++); break;
+                case 3: if (size) list.erase(random() % size); break;
+                case 4: list.pop_back(); break; // Not recorded when empty
+                case 5: if (size) list.access(random() % size); break;
+                case 6: list.for_each(size / 2, size - size / 2, [](uint32_t) {}); break;
+                default: list.push_back(key++);
+            }
+            peak = std::max<uint64_t>(peak, list.size());
+        }
+        EXPECT_THROW(list.erase(list.size()), std::out_of_range);
+        EXPECT_THROW(list.for_each(0, list.size() + 1, [](uint32_t) {}), std::out_of_range);
+        recorded.assign(list.list().begin(), list.list().end());
+    }
+
+    replay::trace trace = replay::load(path);
+    EXPECT_EQ(trace.header.element_size, sizeof(uint32_t));
+    EXPECT_EQ(trace.header.node_max_size, 8u);
+    EXPECT_EQ(trace.peak_size, peak);
+
+    unrolled_list<bench::blob<4>, 16> replayed;
+    replay::run(replayed, trace.records);
+    std::vector<uint32_t> keys;
+    for (const auto& element : replayed) keys.push_back(element.key);
+    EXPECT_EQ(keys, recorded);
+}
+
+TEST_F(RecordingUnrolledList, LoadRejectsOutOfRangeRecords) {
+    {
+        std::ofstream out(path, std::ios::binary);
+        unrolled_list_trace_writer writer(out, 4, 8);
+        writer.record(op::push_back);
+        writer.record(op::erase, 1);
+    }
+    EXPECT_THROW(replay::load(path), std::runtime_error);
+    EXPECT_THROW(replay::load(path + ".missing"), std::runtime_error);
+
+    std::ifstream in(path, std::ios::binary);
+    EXPECT_EQ(read_all(in).size(), 2u); // The trace itself is well formed
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unrolled_list.h>
+
+// Length-prefixed strings for the custom format
+template<>
+struct unrolled_list_serializer<std::string> {
+    static void write(std::ostream& out, const std::string& value) {
+        uint32_t length = uint32_t(value.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(value.data(), std::streamsize(length));
+    }
+
+    static std::string read(std::istream& in) {
+        uint32_t length = 0;
+        in.read(reinterpret_cast<char*>(&length), sizeof(length));
+        std::string value(length, '\0');
+        in.read(value.data(), std::streamsize(length));
+        return value;
+    }
+};
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+struct point {
+    int32_t x;
+    double y;
+
+    bool operator==(const point&) const = default;
+};
+
+unrolled_list<uint64_t, 8> iota(uint64_t count) {
+    unrolled_list<uint64_t, 8> list;
+    for (uint64_t i = 0; i < count; ++i) list.push_back(i * i);
+    return list;
+}
+
+} // namespace
+
+TEST(Serialization, BlockRoundTrip) {
+    auto list = iota(1000);
+    list.insert(std::next(list.begin(), 5), 7); // A node that is not full
+    std::stringstream stream;
+    list.serialize(stream);
+    EXPECT_EQ(stream.str().size(), 24 + list.size() * sizeof(uint64_t));
+
+    auto read = unrolled_list<uint64_t, 8>::deserialize(stream);
+    EXPECT_EQ(read, list);
+    EXPECT_EQ(read.stats().node_count, (list.size() + 7) / 8); // Read into full nodes
+
+    unrolled_list<point, 4> points = {{1, 0.5}, {2, 1.5}, {3, 2.5}, {4, 3.5}, {5, 4.5}};
+    std::stringstream point_stream;
+    points.serialize(point_stream);
+    EXPECT_EQ(to_vector(unrolled_list<point, 4>::deserialize(point_stream)), to_vector(points));
+}
+
+TEST(Serialization, EmptyList) {
+    unrolled_list<int, 4> list;
+    std::stringstream stream;
+    list.serialize(stream);
+    EXPECT_TRUE((unrolled_list<int, 4>::deserialize(stream).empty()));
+}
+
+TEST(Serialization, CustomSerializer) {
+    unrolled_list<std::string, 3> list = {"", "a", "bc", "def", "a longer string than the others"};
+    std::stringstream stream;
+    list.serialize(stream);
+    EXPECT_EQ(to_vector(unrolled_list<std::string, 3>::deserialize(stream)), to_vector(list));
+}
+
+TEST(Serialization, RejectsMismatchedAndTruncatedInput) {
+    auto list = iota(20);
+    std::stringstream stream;
+    list.serialize(stream);
+    std::string bytes = stream.str();
+
+    std::stringstream other_type(bytes);
+    EXPECT_THROW(unrolled_list<uint32_t>::deserialize(other_type), std::runtime_error);
+
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 8));
+    EXPECT_THROW((unrolled_list<uint64_t, 8>::deserialize(truncated)), std::runtime_error);
+
+    std::stringstream garbage(std::string(24, 'x'));
+    EXPECT_THROW((unrolled_list<uint64_t, 8>::deserialize(garbage)), std::runtime_error);
+
+    std::stringstream empty;
+    EXPECT_THROW((unrolled_list<uint64_t, 8>::deserialize(empty)), std::runtime_error);
+}
+
+#ifdef UNROLLED_LIST_POSIX_IO
+TEST(Serialization, FileDescriptorRoundTrip) {
+    auto list = iota(5000);
+    FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    int fd = fileno(file);
+    list.serialize(fd);
+
+    ASSERT_EQ(::lseek(fd, 0, SEEK_SET), 0);
+    auto read = unrolled_list<uint64_t, 8>::deserialize(fd);
+    EXPECT_EQ(read, list);
+
+    ASSERT_EQ(::lseek(fd, 0, SEEK_SET), 0); // The stream and fd formats are the same
+    std::stringstream stream;
+    list.serialize(stream);
+    std::string bytes(stream.str().size(), '\0');
+    ASSERT_EQ(::read(fd, bytes.data(), bytes.size()), ssize_t(bytes.size()));
+    EXPECT_EQ(bytes, stream.str());
+
+    ASSERT_EQ(::ftruncate(fd, 24 + 100 * sizeof(uint64_t)), 0);
+    ASSERT_EQ(::lseek(fd, 0, SEEK_SET), 0);
+    EXPECT_THROW((unrolled_list<uint64_t, 8>::deserialize(fd)), std::runtime_error);
+    std::fclose(file);
+}
+#endif
+
+TEST(Loading, FromStreamFillsFullNodes) {
+    std::vector<uint32_t> values(1000);
+    for (uint32_t i = 0; i < values.size(); ++i) values[i] = i * 7;
+    std::stringstream stream(std::string(reinterpret_cast<const char*>(values.data()), values.size() * 4));
+
+    auto list = unrolled_list<uint32_t, 64>::from_stream(stream);
+    EXPECT_EQ(to_vector(list), values);
+    EXPECT_EQ(list.stats().node_count, 16u);
+    list.push_back(1); // The partial last node takes more elements
+    EXPECT_EQ(list.stats().node_count, 16u);
+
+    std::stringstream empty;
+    EXPECT_TRUE((unrolled_list<uint32_t, 64>::from_stream(empty).empty()));
+
+    std::stringstream ragged(std::string(10, 'x'));
+    EXPECT_THROW((unrolled_list<uint32_t, 64>::from_stream(ragged)), std::runtime_error);
+}
+
+#ifdef UNROLLED_LIST_POSIX_IO
+TEST(Loading, FromFdReadsFilesAndPipes) {
+    std::vector<uint64_t> values(10000);
+    for (uint64_t i = 0; i < values.size(); ++i) values[i] = i * i;
+
+    FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    int fd = fileno(file);
+    ASSERT_EQ(::write(fd, values.data(), values.size() * 8), ssize_t(values.size() * 8));
+    ASSERT_EQ(::lseek(fd, 0, SEEK_SET), 0);
+    auto list = unrolled_list<uint64_t, 128>::from_fd(fd);
+    EXPECT_EQ(to_vector(list), values);
+    EXPECT_EQ(list.stats().node_count, (values.size() + 127) / 128);
+
+    ASSERT_EQ(::lseek(fd, 0, SEEK_SET), 0);
+    EXPECT_EQ(to_vector(unrolled_list<uint64_t, 7>::from_fd(fd, false)), values);
+    std::fclose(file);
+
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ASSERT_EQ(::write(fds[1], values.data(), 300 * 8), 300 * 8);
+    ::close(fds[1]);
+    auto piped = unrolled_list<uint64_t, 16>::from_fd(fds[0]);
+    ::close(fds[0]);
+    EXPECT_EQ(to_vector(piped), std::vector<uint64_t>(values.begin(), values.begin() + 300));
+}
+
+TEST(Loading, SmallInputDoesNotAllocateAWholeBatch) {
+    uint64_t values[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    using list = unrolled_list<uint64_t, 4096>;
+
+    FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(::write(fileno(file), values, sizeof(values)), ssize_t(sizeof(values)));
+    ASSERT_EQ(::lseek(fileno(file), 0, SEEK_SET), 0);
+    auto from_file = list::from_fd(fileno(file));
+    std::fclose(file);
+    EXPECT_EQ(from_file.size(), 10u);
+    EXPECT_LE(from_file.stats().allocations, 4u); // One node, and at most one more to find the end
+
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ASSERT_EQ(::write(fds[1], values, sizeof(values)), ssize_t(sizeof(values)));
+    ::close(fds[1]);
+    auto from_pipe = list::from_fd(fds[0]);
+    ::close(fds[0]);
+    EXPECT_EQ(from_pipe.back(), 10u);
+    EXPECT_LE(from_pipe.stats().allocations, 4u);
+}
+#endif
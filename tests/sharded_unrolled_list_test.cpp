@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <sharded_unrolled_list.h>
+
+namespace {
+
+// Stateful allocator that is not propagated on move assignment, counting
+// allocate calls of every rebound type together
+template<typename T>
+struct tagged_allocator {
+    using value_type = T;
+    int tag = 0;
+    static inline size_t allocations = 0;
+
+    tagged_allocator() = default;
+    explicit tagged_allocator(int tag) : tag(tag) {}
+    template<typename U>
+    tagged_allocator(const tagged_allocator<U>& other) noexcept : tag(other.tag) {}
+
+    T* allocate(size_t n) {
+        ++tagged_allocator<int>::allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const tagged_allocator<U>& other) const noexcept { return tag == other.tag; }
+};
+
+} // namespace
+
+TEST(ShardedUnrolledList, FlattenKeepsShardOrder) {
+    sharded_unrolled_list<int, 4> list(3);
+    EXPECT_EQ(list.shard_count(), 3u);
+    EXPECT_TRUE(list.empty());
+    for (int i = 0; i < 10; ++i) list.push_back(2, 200 + i);
+    for (int i = 0; i < 5; ++i) list.push_back(0, i);
+    list.shard(1).push_back(100);
+
+    std::vector<int> seen;
+    list.for_each([&seen](int value) { seen.push_back(value); });
+    EXPECT_EQ(list.size(), 16u);
+
+    auto flat = list.flatten();
+    EXPECT_EQ(std::vector<int>(flat.begin(), flat.end()), seen);
+    EXPECT_EQ(seen.front(), 0);
+    EXPECT_EQ(seen[5], 100);
+    EXPECT_EQ(seen.back(), 209);
+    EXPECT_TRUE(list.empty());
+
+    list.push_back(1, 1);
+    list.clear();
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(ShardedUnrolledList, ParallelAppendsToOwnShards) {
+    constexpr int Threads = 4;
+    constexpr int PerThread = 10000;
+    sharded_unrolled_list<int, 32> list(Threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&list, t] {
+            for (int i = 0; i < PerThread; ++i) list.push_back(t, t * PerThread + i);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    auto flat = list.flatten();
+    ASSERT_EQ(flat.size(), size_t(Threads * PerThread));
+    int expected = 0;
+    for (int value : flat) EXPECT_EQ(value, expected++);
+}
+
+TEST(ShardedUnrolledList, ShardsUseTheGivenAllocator) {
+    using allocator = tagged_allocator<int>;
+    allocator::allocations = 0;
+    sharded_unrolled_list<int, 4, allocator> list(4, allocator(7));
+    EXPECT_EQ(allocator::allocations, 1u); // The shard array, the empty shards allocate nothing
+    for (size_t i = 0; i < list.shard_count(); ++i) {
+        EXPECT_EQ(list.shard(i).get_allocator().tag, 7);
+        list.push_back(i, int(i));
+    }
+    EXPECT_EQ(list.shard_of(42), list.shard_of(42));
+    EXPECT_LT(list.this_thread_shard(), list.shard_count());
+
+    auto flat = list.flatten();
+    EXPECT_EQ(flat.get_allocator().tag, 7);
+    EXPECT_EQ(std::vector<int>(flat.begin(), flat.end()), (std::vector<int>{0, 1, 2, 3}));
+}
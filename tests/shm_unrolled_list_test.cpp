@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <shm_unrolled_list.h>
+
+namespace {
+
+struct record {
+    uint64_t id;
+    double value;
+};
+
+using list = shm_unrolled_list<record, 8>;
+
+// Segment name unique to the test, unlinked when the test ends
+class ShmUnrolledList : public ::testing::Test {
+protected:
+    std::string name;
+
+    void SetUp() override {
+        name = std::string("/shm_unrolled_list_test_") + std::to_string(::getpid()) + "_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        list::unlink(name);
+    }
+
+    void TearDown() override {
+        list::unlink(name);
+    }
+};
+
+} // namespace
+
+TEST_F(ShmUnrolledList, HandsNodesToAnotherMapping) {
+    list producer = list::create(name, 4);
+    list consumer = list::open(name);
+    EXPECT_TRUE(consumer.empty());
+    EXPECT_FALSE(consumer.try_consume());
+
+    uint64_t next = 0;
+    for (int n = 0; n < 3; ++n) {
+        auto node = producer.acquire();
+        EXPECT_TRUE(node.empty());
+        while (!node.full()) node.push_back(record{next++, 0.5});
+        producer.publish(std::move(node));
+    }
+    EXPECT_EQ(consumer.size(), 24u);
+    EXPECT_EQ(consumer.node_count(), 3u);
+
+    uint64_t expected = 0;
+    for (int n = 0; n < 3; ++n) {
+        auto node = consumer.try_consume();
+        ASSERT_TRUE(node);
+        EXPECT_EQ(node.size(), list::node_handle::capacity());
+        for (const record& item : node.elements()) EXPECT_EQ(item.id, expected++);
+    }
+    EXPECT_TRUE(producer.empty());
+}
+
+TEST_F(ShmUnrolledList, PoolIsFixedAndNodesAreReleased) {
+    list shared = list::create(name, 2);
+    auto first = shared.try_acquire();
+    auto second = shared.try_acquire();
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_FALSE(shared.try_acquire()); // Pool exhausted
+
+    first.reset(); // Dropped without publishing
+    auto third = shared.try_acquire();
+    ASSERT_TRUE(third);
+
+    third.data()[0] = record{7, 1.0};
+    third.resize(1);
+    shared.publish(std::move(third));
+    shared.publish(std::move(second)); // Empty nodes go back to the pool
+    EXPECT_EQ(shared.node_count(), 1u);
+    EXPECT_TRUE(shared.try_acquire());
+
+    {
+        auto node = shared.consume();
+        EXPECT_EQ(node.elements()[0].id, 7u);
+    }
+    auto a = shared.try_acquire();
+    auto b = shared.try_acquire();
+    EXPECT_TRUE(a && b); // Both nodes are back in the pool
+}
+
+TEST_F(ShmUnrolledList, ChildProcessProduces) {
+    constexpr uint64_t Count = 5000;
+    list shared = list::create(name, 4);
+
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        list producer = list::open(name);
+        uint64_t next = 0;
+        while (next < Count) {
+            auto node = producer.acquire(); // Waits while all four nodes are in flight
+            for (; !node.full() && next < Count; ++next) node.push_back(record{next, double(next)});
+            producer.publish(std::move(node));
+        }
+        producer.close();
+        ::_exit(0);
+    }
+
+    std::vector<uint64_t> ids;
+    while (auto node = shared.consume()) {
+        for (const record& item : node.elements()) ids.push_back(item.id);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    ASSERT_EQ(ids.size(), Count);
+    for (uint64_t i = 0; i < Count; ++i) EXPECT_EQ(ids[i], i);
+    EXPECT_FALSE(shared.consume()); // Closed and drained
+}
+
+TEST_F(ShmUnrolledList, CreateFailsIfTheNameExists) {
+    list shared = list::create(name, 1);
+    EXPECT_THROW(list::create(name, 1), std::system_error);
+    list::unlink(name);
+    EXPECT_THROW(list::open(name), std::system_error);
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <spilling_unrolled_list.h>
+
+namespace {
+
+// Single pass: a second iterator over the range may evict the block the first one holds
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    std::vector<typename List::value_type> values;
+    for (const auto& value : list) values.push_back(value);
+    return values;
+}
+
+// Blocks of 64 uint64_t, budgets are given in blocks
+using list = spilling_unrolled_list<uint64_t, 64>;
+constexpr size_t BlockBytes = 64 * sizeof(uint64_t);
+
+std::string spill_directory() {
+    return std::filesystem::temp_directory_path().string();
+}
+
+} // namespace
+
+TEST(SpillingUnrolledList, MatchesVectorWhileSpilling) {
+    list spilled(4 * BlockBytes, spill_directory());
+    EXPECT_EQ(spilled.max_resident_nodes(), 4u);
+    std::vector<uint64_t> expected;
+    std::mt19937 random(3);
+    for (uint64_t i = 0; i < 5000; ++i) {
+        size_t pos = expected.empty() ? 0 : random() % (expected.size() + 1);
+        switch (random() % 4) {
+            case 0:
+            case 1:
+                spilled.push_back(i);
+                expected.push_back(i);
+                break;
+            case 2:
+                spilled.insert(pos, i);
+                expected.insert(expected.begin() + pos, i);
+                break;
+            default:
+                if (pos < expected.size()) {
+                    spilled.erase(pos);
+                    expected.erase(expected.begin() + pos);
+                }
+        }
+        EXPECT_LE(spilled.resident_nodes(), 4u);
+    }
+    EXPECT_EQ(to_vector(spilled), expected);
+    for (size_t i = 0; i < expected.size(); i += 13) EXPECT_EQ(std::as_const(spilled)[i], expected[i]);
+    spilled[0] = 42; // Writes through operator[] survive eviction
+    expected[0] = 42;
+    EXPECT_EQ(spilled.back(), expected.back());
+    EXPECT_EQ(to_vector(spilled), expected);
+    EXPECT_THROW(spilled.at(expected.size()), std::out_of_range);
+    EXPECT_GT(spilled.stats().evictions, 0u);
+    EXPECT_GT(spilled.stats().misses, 0u);
+}
+
+TEST(SpillingUnrolledList, AppendsFillNodes) {
+    list spilled(4 * BlockBytes, spill_directory());
+    for (uint64_t i = 0; i < 6400; ++i) spilled.push_back(i);
+    EXPECT_EQ(spilled.resident_nodes(), 4u);
+    EXPECT_EQ(spilled.stats().evictions, 96u); // 100 full nodes, 4 of them resident
+    EXPECT_EQ(spilled.stats().bytes_written, 96 * BlockBytes);
+    EXPECT_EQ(spilled.spill_file_size(), 96 * BlockBytes);
+}
+
+TEST(SpillingUnrolledList, ScansWriteEachBlockOnce) {
+    list spilled(4 * BlockBytes, spill_directory());
+    for (uint64_t i = 0; i < 640; ++i) spilled.push_back(i);
+    spilled.reset_stats();
+
+    for (int scan = 0; scan < 2; ++scan) {
+        uint64_t expected = 0;
+        for (uint64_t value : spilled) EXPECT_EQ(value, expected++);
+        EXPECT_EQ(expected, 640u);
+    }
+    const auto& stats = spilled.stats();
+    EXPECT_EQ(stats.misses, 20u); // A scan longer than the budget misses on every node
+    EXPECT_EQ(stats.bytes_read, 20 * BlockBytes);
+    EXPECT_EQ(stats.bytes_written, 4 * BlockBytes); // Only the blocks never spilled, clean ones are dropped
+    EXPECT_EQ(spilled.spill_file_size(), 10 * BlockBytes);
+
+    spilled.clear();
+    EXPECT_TRUE(spilled.empty());
+    EXPECT_EQ(spilled.spill_file_size(), 0u);
+    spilled.push_back(1);
+    EXPECT_EQ(spilled.front(), 1u);
+}
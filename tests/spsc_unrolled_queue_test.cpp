@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <spsc_unrolled_queue.h>
+
+namespace {
+
+// Counts live objects to check that the queue destroys what it holds
+struct tracked {
+    static inline int live = 0;
+    int value;
+
+    explicit tracked(int value) : value(value) { ++live; }
+    tracked(const tracked& other) : value(other.value) { ++live; }
+    tracked(tracked&& other) noexcept : value(other.value) { ++live; }
+    tracked& operator=(tracked&&) noexcept = default;
+    ~tracked() { --live; }
+};
+
+// Counts node allocations
+template<typename T>
+struct counting_allocator {
+    using value_type = T;
+    static inline size_t allocations = 0;
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        ++allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const counting_allocator<U>&) const noexcept { return true; }
+};
+
+} // namespace
+
+TEST(SpscUnrolledQueue, FifoAcrossNodes) {
+    spsc_unrolled_queue<int, 4> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.try_pop().has_value());
+    for (int i = 0; i < 50; ++i) queue.push(i);
+    EXPECT_FALSE(queue.empty());
+    for (int i = 0; i < 50; ++i) {
+        int value = -1;
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_TRUE(queue.empty());
+    int value;
+    EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(SpscUnrolledQueue, InterleavedPushAndPop) {
+    spsc_unrolled_queue<std::string, 3> queue;
+    int next_in = 0;
+    int next_out = 0;
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < round % 7; ++i) queue.emplace(std::to_string(next_in++));
+        for (int i = 0; i < round % 5; ++i) {
+            auto value = queue.try_pop();
+            if (!value) break;
+            EXPECT_EQ(*value, std::to_string(next_out++));
+        }
+    }
+    while (auto value = queue.try_pop()) EXPECT_EQ(*value, std::to_string(next_out++));
+    EXPECT_EQ(next_in, next_out);
+}
+
+TEST(SpscUnrolledQueue, SteadyStateRecyclesNodes) {
+    using allocator = counting_allocator<int>;
+    spsc_unrolled_queue<int, 8, allocator> queue;
+    for (int i = 0; i < 64; ++i) {
+        queue.push(i);
+        queue.try_pop();
+    }
+    size_t warm = allocator::allocations;
+    for (int i = 0; i < 10000; ++i) {
+        queue.push(i);
+        EXPECT_EQ(queue.try_pop(), i);
+    }
+    EXPECT_EQ(allocator::allocations, warm);
+}
+
+TEST(SpscUnrolledQueue, DestroysRemainingElements) {
+    {
+        spsc_unrolled_queue<tracked, 4> queue;
+        for (int i = 0; i < 10; ++i) queue.emplace(i);
+        for (int i = 0; i < 5; ++i) queue.try_pop();
+        EXPECT_EQ(tracked::live, 5);
+    }
+    EXPECT_EQ(tracked::live, 0);
+}
+
+TEST(SpscUnrolledQueue, ProducerAndConsumerThreads) {
+    constexpr int Count = 200000;
+    spsc_unrolled_queue<int, 16> queue;
+    std::thread producer([&queue] {
+        for (int i = 0; i < Count; ++i) queue.push(i);
+    });
+    int expected = 0;
+    bool ordered = true;
+    while (expected < Count) {
+        if (auto value = queue.try_pop()) {
+            ordered = ordered && *value == expected;
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.empty());
+}
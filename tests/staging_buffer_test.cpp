@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unrolled_list.h>
+
+namespace {
+
+template<typename List>
+std::vector<typename List::value_type> to_vector(const List& list) {
+    return {list.begin(), list.end()};
+}
+
+// Counts live objects and copies to check that commit moves nothing
+struct tracked {
+    static inline int live = 0;
+    static inline int copies = 0;
+    int value;
+
+    explicit tracked(int value) : value(value) { ++live; }
+    tracked(const tracked& other) : value(other.value) { ++live; ++copies; }
+    tracked(tracked&& other) noexcept : value(other.value) { ++live; ++copies; }
+    ~tracked() { --live; }
+};
+
+} // namespace
+
+TEST(StagingBuffer, CommitAppendsInOrder) {
+    unrolled_list<std::string, 4> target = {"a", "b"};
+    auto buffer = target.make_staging_buffer();
+    EXPECT_TRUE(buffer.empty());
+    buffer.commit(target); // Nothing staged
+    EXPECT_EQ(target.size(), 2u);
+
+    for (int i = 0; i < 6; ++i) buffer.push_back(std::to_string(i));
+    buffer.emplace_back(3, 'x');
+    EXPECT_EQ(buffer.size(), 7u);
+    buffer.commit(target);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(to_vector(target), (std::vector<std::string>{"a", "b", "0", "1", "2", "3", "4", "5", "xxx"}));
+    EXPECT_EQ(target.back(), "xxx");
+
+    buffer.push_back("y"); // The buffer is reusable after a commit
+    buffer.clear();
+    buffer.push_back("z");
+    buffer.commit(target);
+    EXPECT_EQ(target.back(), "z");
+    EXPECT_EQ(target.size(), 10u);
+}
+
+TEST(StagingBuffer, CommitDoesNotTouchElements) {
+    {
+        unrolled_list<tracked, 8> target;
+        auto buffer = target.make_staging_buffer();
+        for (int i = 0; i < 20; ++i) buffer.emplace_back(i);
+        tracked::copies = 0;
+        buffer.commit(target);
+        EXPECT_EQ(tracked::copies, 0);
+        EXPECT_EQ(tracked::live, 20);
+        EXPECT_EQ(target.back().value, 19);
+    }
+    EXPECT_EQ(tracked::live, 0);
+}
+
+TEST(StagingBuffer, ThreadsCommitWholeBatches) {
+    constexpr int Threads = 4;
+    constexpr int Batches = 50;
+    constexpr int Batch = 37;
+    unrolled_list<int, 16> target;
+    std::mutex mutex;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < Threads; ++t) {
+        workers.emplace_back([&, t] {
+            auto buffer = target.make_staging_buffer();
+            for (int b = 0; b < Batches; ++b) {
+                for (int i = 0; i < Batch; ++i) buffer.push_back((t * Batches + b) * Batch + i);
+                buffer.commit(target, mutex);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    auto values = to_vector(target);
+    ASSERT_EQ(values.size(), size_t(Threads * Batches * Batch));
+    for (size_t i = 0; i < values.size(); i += Batch) { // Batches are never interleaved
+        EXPECT_EQ(values[i] % Batch, 0);
+        for (int k = 1; k < Batch; ++k) EXPECT_EQ(values[i + k], values[i] + k);
+    }
+    std::sort(values.begin(), values.end());
+    for (size_t i = 0; i < values.size(); ++i) EXPECT_EQ(values[i], int(i));
+}
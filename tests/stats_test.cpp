@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include <unrolled_list.h>
+
+namespace {
+
+using list = unrolled_list<uint32_t, 8>;
+
+list iota(uint32_t count) {
+    list result;
+    for (uint32_t i = 0; i < count; ++i) result.push_back(i);
+    return result;
+}
+
+} // namespace
+
+TEST(Stats, EmptyList) {
+    list values;
+    auto stats = values.stats();
+    EXPECT_EQ(stats.node_count, 0u);
+    EXPECT_EQ(stats.element_count, 0u);
+    EXPECT_EQ(stats.min_node_size, 0u);
+    EXPECT_EQ(stats.max_node_size, 0u);
+    EXPECT_EQ(stats.average_node_size, 0.0);
+    EXPECT_EQ(stats.fill_factor(), 0.0);
+    EXPECT_EQ(stats.overhead_bytes, 0u);
+    EXPECT_EQ(stats.allocations, 0u);
+}
+
+TEST(Stats, ShapeAndBytes) {
+    list values = iota(20); // Nodes of 8, 8 and 4
+    auto stats = values.stats();
+    EXPECT_EQ(stats.node_count, 3u);
+    EXPECT_EQ(stats.element_count, 20u);
+    EXPECT_EQ(stats.min_node_size, 4u);
+    EXPECT_EQ(stats.max_node_size, 8u);
+    EXPECT_DOUBLE_EQ(stats.average_node_size, 20.0 / 3);
+    EXPECT_DOUBLE_EQ(stats.fill_factor(), 20.0 / 24);
+    EXPECT_EQ(stats.fill_histogram[9], 2u); // Full nodes
+    EXPECT_EQ(stats.fill_histogram[5], 1u); // Half full
+    EXPECT_EQ(stats.element_bytes, 20 * sizeof(uint32_t));
+    EXPECT_EQ(stats.block_bytes, 24 * sizeof(uint32_t));
+    EXPECT_EQ(stats.slack_bytes, 4 * sizeof(uint32_t));
+    EXPECT_GT(stats.header_bytes, 0u);
+    EXPECT_EQ(stats.header_bytes % 3, 0u);
+    EXPECT_EQ(stats.overhead_bytes, stats.header_bytes + stats.slack_bytes);
+}
+
+TEST(Stats, AllocatorCallsOfThisList) {
+    list values = iota(20);
+    EXPECT_EQ(values.stats().allocations, 6u); // A header and a block per node
+    for (int i = 0; i < 5; ++i) values.pop_back(); // Empties the tail node
+    EXPECT_EQ(values.stats().deallocations, 2u);
+    values.clear();
+    EXPECT_EQ(values.stats().deallocations, 6u);
+    EXPECT_EQ(values.stats().allocations, 6u); // Counters survive clear
+}
+
+TEST(Stats, AdoptedNodesStayCountedWhereAllocated) {
+    list target = iota(8);
+    list other = iota(16);
+    target.splice(target.end(), other);
+    EXPECT_EQ(target.stats().node_count, 3u);
+    EXPECT_EQ(target.stats().allocations, 2u);
+    EXPECT_EQ(other.stats().allocations, 4u);
+
+    auto buffer = target.make_staging_buffer();
+    for (uint32_t i = 0; i < 8; ++i) buffer.push_back(i);
+    buffer.commit(target);
+    EXPECT_EQ(target.stats().node_count, 4u);
+    EXPECT_EQ(target.stats().allocations, 2u);
+
+    target.clear(); // Frees nodes it never allocated
+    EXPECT_EQ(target.stats().deallocations, 8u);
+    EXPECT_EQ(other.stats().deallocations, 0u);
+}
@@ -0,0 +1,238 @@
+// Recommends a NodeMaxSize for a workload: replays an operation mix or a
+// recorded trace against unrolled_list with every candidate capacity,
+// measures time per operation and peak allocated bytes, and prints the
+// capacity to use together with a header snippet. Peak memory counts node
+// headers and element blocks at the most nodes alive during the workload.
+//
+// Usage: node_size_tuner [--trace=<path> | --mix=<op>=<weight>,... --size=<n> --ops=<n>]
+//                        [--iterate-length=<n>] [--element-size=<bytes>] [--type=<name>] [--alias=<name>]
+//                        [--tolerance=<fraction>] [--seed=<n>] [harness options]
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unrolled_list.h>
+
+#include "bench_harness.h"
+#include "replay.h"
+
+namespace {
+
+constexpr std::string_view op_names[] = {
+    "push_back", "push_front", "pop_back", "pop_front", "insert", "erase", "access", "iterate", "clear"};
+
+struct options {
+    std::string trace_path;
+    std::vector<double> weights = std::vector<double>(std::size(op_names), 0.0);
+    size_t size = 10'000; // Elements before the mix starts
+    size_t ops = 100'000; // Operations in the mix
+    size_t iterate_length = 100; // Elements read by one iterate operation
+    size_t element_size = 8;
+    std::string type = "T";
+    std::string alias = "my_list";
+    double tolerance = 0.05; // Capacities this much slower than the fastest still count as fastest
+    uint32_t seed = 42;
+};
+
+// Parses "push_back=50,insert=20,..." into weights, which must not be negative
+// and must not all be zero
+void parse_mix(std::string_view text, std::vector<double>& weights) {
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view item = text.substr(0, comma);
+        size_t equals = item.find('=');
+        std::string_view name = item.substr(0, equals);
+        auto op = std::find(std::begin(op_names), std::end(op_names), name);
+        if (op == std::end(op_names) || equals == std::string_view::npos) {
+            throw std::runtime_error("bad --mix entry " + std::string(item));
+        }
+        double weight = std::atof(std::string(item.substr(equals + 1)).c_str());
+        if (!(weight >= 0)) throw std::runtime_error("negative --mix weight " + std::string(item));
+        weights[size_t(op - std::begin(op_names))] = weight;
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    }
+    // discrete_distribution needs at least one positive weight
+    if (std::accumulate(weights.begin(), weights.end(), 0.0) <= 0) {
+        throw std::runtime_error("--mix needs at least one operation with a positive weight");
+    }
+}
+
+// Synthetic trace: size push_backs, then ops operations drawn from the mix at
+// uniformly random positions. Removals and reads of an empty list become pushes.
+std::vector<unrolled_list_trace_record> generate(const options& opts) {
+    std::vector<unrolled_list_trace_record> records;
+    records.reserve(opts.size + opts.ops);
+    for (size_t i = 0; i < opts.size; ++i) records.push_back({unrolled_list_trace_op::push_back});
+
+    std::mt19937_64 random(opts.seed);
+    std::discrete_distribution<size_t> pick(opts.weights.begin(), opts.weights.end());
+    uint64_t size = opts.size;
+    auto position = [&](uint64_t bound) { return bound ? random() % bound : 0; };
+    for (size_t i = 0; i < opts.ops; ++i) {
+        auto op = unrolled_list_trace_op(pick(random));
+        bool removes = op == unrolled_list_trace_op::pop_back || op == unrolled_list_trace_op::pop_front
+            || op == unrolled_list_trace_op::erase || op == unrolled_list_trace_op::access;
+        if (size == 0 && removes) op = unrolled_list_trace_op::push_back;
+
+        unrolled_list_trace_record record{op};
+        switch (op) {
+            case unrolled_list_trace_op::push_back:
+            case unrolled_list_trace_op::push_front: ++size; break;
+            case unrolled_list_trace_op::pop_back:
+            case unrolled_list_trace_op::pop_front: --size; break;
+            case unrolled_list_trace_op::insert: record.position = position(size + 1); ++size; break;
+            case unrolled_list_trace_op::erase: record.position = position(size); --size; break;
+            case unrolled_list_trace_op::access: record.position = position(size); break;
+            case unrolled_list_trace_op::iterate:
+                record.count = std::min<uint64_t>(opts.iterate_length, size);
+                record.position = position(size - record.count + 1);
+                break;
+            case unrolled_list_trace_op::clear: size = 0; break;
+        }
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Instrumentation policy that tracks the most nodes alive at once
+struct node_peak_instrumentation : unrolled_list_no_instrumentation {
+    static constexpr bool enabled = true;
+
+    size_t live = 0;
+    size_t peak = 0;
+
+    void node_created() noexcept { peak = std::max(peak, ++live); }
+    void node_destroyed() noexcept { --live; }
+};
+
+struct candidate {
+    size_t node_max_size;
+    double ns_per_op;
+    size_t peak_bytes;
+};
+
+template<typename T, size_t NodeMaxSize>
+candidate measure(bench::runner& runner, const std::vector<unrolled_list_trace_record>& records) {
+    bench::case_info info{"tune", "unrolled_list", sizeof(T), NodeMaxSize, records.size()};
+    runner.run(info, records.size(), [&] {
+        unrolled_list<T, NodeMaxSize> list;
+        return bench::time_seconds([&] { replay::run(list, records); });
+    });
+    if (runner.measured().empty() || runner.measured().back().info.node_max_size != NodeMaxSize) {
+        return {NodeMaxSize, 0, 0}; // Filtered out
+    }
+
+    // Counted in a separate, untimed pass; a node costs its header and its element block
+    unrolled_list<T, NodeMaxSize, std::allocator<T>, node_peak_instrumentation> list;
+    list.push_back(T());
+    auto stats = list.stats();
+    size_t node_bytes = stats.header_bytes + stats.block_bytes;
+    list.clear();
+    list.instrumentation() = node_peak_instrumentation();
+    replay::run(list, records);
+    return {NodeMaxSize, runner.measured().back().ns_per_op, list.instrumentation().peak * node_bytes};
+}
+
+template<typename T, size_t... NodeMaxSizes>
+std::vector<candidate> measure_all(bench::runner& runner, const std::vector<unrolled_list_trace_record>& records) {
+    std::vector<candidate> candidates = {measure<T, NodeMaxSizes>(runner, records)...};
+    std::erase_if(candidates, [](const candidate& c) { return c.ns_per_op == 0; });
+    return candidates;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        options opts;
+        bool mixed = false;
+        std::vector<char*> harness_args = {argv[0]};
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto value = [&](std::string_view prefix) { return std::string(arg.substr(prefix.size())); };
+            if (arg.starts_with("--trace=")) {
+                opts.trace_path = value("--trace=");
+            } else if (arg.starts_with("--mix=")) {
+                parse_mix(arg.substr(6), opts.weights);
+                mixed = true;
+            } else if (arg.starts_with("--size=")) {
+                opts.size = std::stoull(value("--size="));
+            } else if (arg.starts_with("--ops=")) {
+                opts.ops = std::stoull(value("--ops="));
+            } else if (arg.starts_with("--iterate-length=")) {
+                opts.iterate_length = std::stoull(value("--iterate-length="));
+            } else if (arg.starts_with("--element-size=")) {
+                opts.element_size = std::stoull(value("--element-size="));
+            } else if (arg.starts_with("--type=")) {
+                opts.type = value("--type=");
+            } else if (arg.starts_with("--alias=")) {
+                opts.alias = value("--alias=");
+            } else if (arg.starts_with("--tolerance=")) {
+                opts.tolerance = std::stod(value("--tolerance="));
+            } else if (arg.starts_with("--seed=")) {
+                opts.seed = uint32_t(std::stoul(value("--seed=")));
+            } else {
+                harness_args.push_back(argv[i]);
+            }
+        }
+
+        std::vector<unrolled_list_trace_record> records;
+        std::string workload;
+        if (!opts.trace_path.empty()) {
+            replay::trace trace = replay::load(opts.trace_path);
+            records = std::move(trace.records);
+            opts.element_size = trace.header.element_size;
+            workload = "trace " + opts.trace_path;
+        } else {
+            if (!mixed) parse_mix("push_back=40,pop_front=10,insert=20,erase=10,iterate=10,access=10", opts.weights);
+            records = generate(opts);
+            workload = std::to_string(opts.size) + " elements, " + std::to_string(opts.ops) + " operations of the mix";
+        }
+
+        bench::runner runner(int(harness_args.size()), harness_args.data());
+        std::vector<candidate> candidates;
+        replay::with_element_size(opts.element_size, [&]<size_t Size>() {
+            candidates = measure_all<bench::blob<Size>, 4, 8, 16, 32, 64, 128, 256, 512, 1024>(runner, records);
+        });
+        int status = runner.finish();
+        if (candidates.empty()) {
+            std::cerr << "no capacity was measured\n";
+            return EXIT_FAILURE;
+        }
+
+        // Among the capacities within tolerance of the fastest, the one that needs the least memory
+        double fastest = std::min_element(candidates.begin(), candidates.end(), [](auto& a, auto& b) {
+            return a.ns_per_op < b.ns_per_op;
+        })->ns_per_op;
+        const candidate* best = nullptr;
+        std::cout << "\n" << std::setw(12) << "NodeMaxSize" << std::setw(12) << "ns/op" << std::setw(16)
+                  << "peak bytes" << "\n";
+        for (const candidate& c : candidates) {
+            std::cout << std::setw(12) << c.node_max_size << std::setw(12) << std::fixed << std::setprecision(2)
+                      << c.ns_per_op << std::setw(16) << c.peak_bytes << "\n";
+            if (c.ns_per_op <= fastest * (1 + opts.tolerance) && (!best || c.peak_bytes < best->peak_bytes)) {
+                best = &c;
+            }
+        }
+
+        std::cout << "\nRecommended NodeMaxSize: " << best->node_max_size << "\n\n"
+                  << "// " << opts.element_size << "-byte elements, " << workload << ":\n"
+                  << "// " << best->ns_per_op << " ns/op, " << best->peak_bytes << " peak bytes\n"
+                  << "using " << opts.alias << " = unrolled_list<" << opts.type << ", " << best->node_max_size
+                  << ">;\n";
+        return status;
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+// Loading and replaying workload traces written by recording_unrolled_list,
+// shared by the tools
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <recording_unrolled_list.h>
+
+#include "bench_harness.h"
+
+namespace replay {
+
+struct trace {
+    unrolled_list_trace_header header;
+    std::vector<unrolled_list_trace_record> records;
+    uint64_t peak_size = 0; // Most elements held at once
+};
+
+// Reads a whole trace and checks that every position is valid for a list
+// that starts out empty, so replays need no bounds checks
+inline trace load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + path);
+    unrolled_list_trace_reader reader(in);
+
+    trace result;
+    result.header = reader.header();
+    uint64_t size = 0;
+    unrolled_list_trace_record record;
+    while (reader.next(record)) {
+        bool valid = true;
+        switch (record.op) {
+            case unrolled_list_trace_op::push_back:
+            case unrolled_list_trace_op::push_front: ++size; break;
+            case unrolled_list_trace_op::pop_back:
+            case unrolled_list_trace_op::pop_front: valid = size > 0; --size; break;
+            case unrolled_list_trace_op::insert: valid = record.position <= size; ++size; break;
+            case unrolled_list_trace_op::erase: valid = record.position < size; --size; break;
+            case unrolled_list_trace_op::access: valid = record.position < size; break;
+            case unrolled_list_trace_op::iterate:
+                valid = record.position <= size && record.count <= size - record.position;
+                break;
+            case unrolled_list_trace_op::clear: size = 0; break;
+        }
+        if (!valid) {
+            throw std::runtime_error(path + ": record " + std::to_string(result.records.size()) + " is out of range");
+        }
+        result.peak_size = std::max(result.peak_size, size);
+        result.records.push_back(record);
+    }
+    return result;
+}
+
+// Performs the traced operations on c, which starts out empty
+template<typename Container>
+void run(Container& c, const std::vector<unrolled_list_trace_record>& records) {
+    using T = typename Container::value_type;
+    uint64_t sum = 0;
+    uint32_t key = 0;
+    for (const unrolled_list_trace_record& record : records) {
+        switch (record.op) {
+            case unrolled_list_trace_op::push_back: c.push_back(T(key++)); break;
+            case unrolled_list_trace_op::push_front:
+                if constexpr (requires { c.push_front(T()); }) {
+                    c.push_front(T(key++));
+                } else {
+                    c.insert(c.begin(), T(key++));
+                }
+                break;
+            case unrolled_list_trace_op::pop_back: c.pop_back(); break;
+            case unrolled_list_trace_op::pop_front:
+                if constexpr (requires { c.pop_front(); }) {
+                    c.pop_front();
+                } else {
+                    c.erase(c.begin());
+                }
+                break;
+            case unrolled_list_trace_op::insert: c.insert(std::next(c.begin(), record.position), T(key++)); break;
+            case unrolled_list_trace_op::erase: c.erase(std::next(c.begin(), record.position)); break;
+            case unrolled_list_trace_op::access:
+                if constexpr (requires { c[0]; }) {
+                    sum += c[record.position].key;
+                } else {
+                    sum += std::next(c.begin(), record.position)->key;
+                }
+                break;
+            case unrolled_list_trace_op::iterate: {
+                auto it = std::next(c.begin(), record.position);
+                for (uint64_t i = 0; i < record.count; ++i, ++it) sum += it->key;
+                break;
+            }
+            case unrolled_list_trace_op::clear: c.clear(); break;
+        }
+    }
+    bench::do_not_optimize(sum);
+}
+
+// Calls f.template operator()<Size>() with the smallest supported element size
+// that holds element_size bytes
+template<typename F>
+void with_element_size(size_t element_size, F&& f) {
+    auto attempt = [&]<size_t Size>() {
+        if (element_size > Size) return false;
+        f.template operator()<Size>();
+        return true;
+    };
+    bool done = attempt.template operator()<4>() || attempt.template operator()<8>()
+        || attempt.template operator()<16>() || attempt.template operator()<32>()
+        || attempt.template operator()<64>() || attempt.template operator()<128>()
+        || attempt.template operator()<256>();
+    if (!done) throw std::runtime_error("element size " + std::to_string(element_size) + " is not supported");
+}
+
+} // namespace replay
@@ -0,0 +1,84 @@
+// Replays a workload trace recorded with recording_unrolled_list against
+// unrolled_list with several NodeMaxSize values and allocators and against
+// std::vector, std::deque and std::list, and reports the time per operation.
+//
+// Usage: trace_replay <trace> [--filter=<text>] [--min-time=<seconds>] [--json=<path>] [--counters]
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <unrolled_list.h>
+
+#include "bench_harness.h"
+#include "replay.h"
+
+namespace {
+
+template<typename Container>
+void replay_default(bench::runner& runner, const replay::trace& trace, const std::string& container,
+                    size_t node_max_size) {
+    using T = typename Container::value_type;
+    bench::case_info info{"replay", container, sizeof(T), node_max_size, trace.records.size()};
+    runner.run(info, trace.records.size(), [&] {
+        Container c;
+        return bench::time_seconds([&] { replay::run(c, trace.records); });
+    });
+}
+
+// Same, with the container drawing from a pool resource that lives for one sample
+template<typename Container>
+void replay_pool(bench::runner& runner, const replay::trace& trace, const std::string& container,
+                 size_t node_max_size) {
+    using T = typename Container::value_type;
+    bench::case_info info{"replay", container + "+pool", sizeof(T), node_max_size, trace.records.size()};
+    runner.run(info, trace.records.size(), [&] {
+        std::pmr::unsynchronized_pool_resource pool;
+        Container c{std::pmr::polymorphic_allocator<T>(&pool)};
+        return bench::time_seconds([&] { replay::run(c, trace.records); });
+    });
+}
+
+template<typename T, size_t... NodeMaxSizes>
+void replay_unrolled(bench::runner& runner, const replay::trace& trace) {
+    (replay_default<unrolled_list<T, NodeMaxSizes>>(runner, trace, "unrolled_list", NodeMaxSizes), ...);
+    (replay_pool<unrolled_list<T, NodeMaxSizes, std::pmr::polymorphic_allocator<T>>>(
+        runner, trace, "unrolled_list", NodeMaxSizes), ...);
+}
+
+template<size_t Size>
+void replay_all(bench::runner& runner, const replay::trace& trace) {
+    using T = bench::blob<Size>;
+    replay_unrolled<T, 8, 16, 32, 64, 128, 256, 512>(runner, trace);
+    replay_default<std::vector<T>>(runner, trace, "vector", 0);
+    replay_default<std::deque<T>>(runner, trace, "deque", 0);
+    replay_default<std::list<T>>(runner, trace, "list", 0);
+    replay_pool<std::pmr::list<T>>(runner, trace, "list", 0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || std::string(argv[1]).starts_with("--")) {
+        std::cerr << "usage: " << argv[0] << " <trace> [--filter=<text>] [--min-time=<seconds>] [--json=<path>]"
+                  << " [--counters]\n";
+        return EXIT_FAILURE;
+    }
+    try {
+        replay::trace trace = replay::load(argv[1]);
+        std::cout << argv[1] << ": " << trace.records.size() << " operations, element size "
+                  << trace.header.element_size << ", recorded with NodeMaxSize " << trace.header.node_max_size
+                  << ", peak size " << trace.peak_size << "\n";
+        argv[1] = argv[0]; // The harness parses the remaining options
+        bench::runner runner(argc - 1, argv + 1);
+        replay::with_element_size(trace.header.element_size, [&]<size_t Size>() { replay_all<Size>(runner, trace); });
+        return runner.finish();
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}